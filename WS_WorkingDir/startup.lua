@@ -9,6 +9,10 @@ LoadAllModels()
 local player 	= CreateEntity()
 local tc 		= AddTransformComponent( player ) 
 local rbc 		= AddRigidbodyComponent( player )
+-- doom's player in map units: radius 16, eyes 41 above the feet, steps up to 24 high
+rbc.radius		= 16
+rbc.height		= 25
+rbc.stepHeight	= 24
 -- local mc		= AddMeshComponent( player ) 
 -- mc.meshName 	= "nullmesh"
 
@@ -26,5 +30,5 @@ if test_scene then
 else 
 	SetActiveScene("scene")
 	AddEntityToScene( player, "scene" )	
-	GetPlayerController():setPosition( vec3:new( -1057, 35, -3623  ) )	
+	GetPlayerController():setPosition( vec3:new( -1057, 42, -3623  ) )	
 end 
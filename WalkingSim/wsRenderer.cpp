@@ -14,8 +14,8 @@ void WsOverlay::update( VkCommandBuffer commandBuffer )
 
 	Camera* cam = Camera::instance();
 	PlayerController* pc = PlayerController::instance();
-	TransformComponent* tc = EntityManager::instance()->get<TransformComponent>( pc->getPlayerId() );
-	RigidbodyComponent* rc = EntityManager::instance()->get<RigidbodyComponent>( pc->getPlayerId() );
+	const TransformComponent* tc = EntityManager::instance()->getConst<TransformComponent>( pc->getPlayerId() );
+	const RigidbodyComponent* rc = EntityManager::instance()->getConst<RigidbodyComponent>( pc->getPlayerId() );
 
 	ImGui::NewFrame();
 
@@ -40,8 +40,13 @@ void WsOverlay::update( VkCommandBuffer commandBuffer )
 	ImGui::Text( "Rotation:\n x:\t%f\n y:\t%f\n z:\t%f",
 		tc->rotation.x, tc->rotation.y, tc->rotation.z );
 
+	ImGui::Text( "Component heap allocs: %zu", 
+		EntityManager::instance()->getComponentHeapAllocations() );
+
 	ImGui::End();
 
+	drawTaskSchedulerWindow();
+
 	ImGui::Render();
 
 	if ( checkBuffers() )
@@ -14,12 +14,18 @@
 #include "camera.hpp"
 #include "physicsSystem.hpp"
 #include "eventManager.hpp"
+#include "taskScheduler.hpp"
+#include "components.hpp"
 
 CVar window_width(	"window_width",		"1280" );
 CVar window_height(	"window_height",	"800" );
 CVar window_title(	"window_title",		"No Name Engine" );
 CVar print_fps(		"print_fps",		"0" );
 CVar use_physics(	"physics",			"1" );
+CVar ts_profile(	"ts_profile",		"0" );
+CVar ts_threads(	"ts_threads",		"0" );
+CVar ts_pin_workers( "ts_pin_workers",	"0" );
+CVar ts_reserve_main( "ts_reserve_main", "1" );
 
 std::unique_ptr<Application> Application::_instance = std::make_unique<Application>();
 
@@ -131,6 +137,12 @@ bool Application::init()
 
 	initGLFW();
 
+	TaskSchedulerConfig schedulerConfig;
+	schedulerConfig.threads = (size_t)std::max( ts_threads.intValue, 0 );
+	schedulerConfig.pinWorkers = ts_pin_workers.intValue == 1;
+	schedulerConfig.reserveMainThread = ts_reserve_main.intValue == 1;
+
+	TaskScheduler::instance()->initialize( schedulerConfig );
 	EntityManager::instance()->initialize();
 
 	Renderer::instance()->init();
@@ -155,9 +167,35 @@ bool Application::init()
 
 	Camera::instance()->initCamera();
 
+	buildFrameGraph();
+
 	return true;
 }
 
+void Application::buildFrameGraph()
+{
+	frameGraph.clear();
+
+	// nodes touching the same components run in the order they are added here,
+	// anything that doesn't conflict is free to overlap on the workers
+	TaskGraph::NodeId physics = frameGraph.add( "physics", [this]() 
+	{
+		if ( use_physics.intValue != 0 )
+		{
+			PhysicsSystem::instance()->update(
+				frameCounter.lastFrameTimeInSeconds() );
+		}
+	} );
+	frameGraph.writes<TransformComponent, RigidbodyComponent>( physics );
+
+	// follows the player and writes its facing direction back
+	TaskGraph::NodeId camera = frameGraph.add( "camera", []() 
+	{
+		Camera::instance()->update();
+	} );
+	frameGraph.writes<TransformComponent>( camera );
+}
+
 void SetWindowDebugTitle( GLFWwindow* window, int frameRate )
 {
 	char name[64];
@@ -179,14 +217,12 @@ void Application::run()
 
 		SceneManager::instance()->fireSceneEvents( enu_EVENT_TYPE::post_input );
 
-	// Systems
-		if ( use_physics.intValue != 0 )
-		{
-			PhysicsSystem::instance()->update(
-				frameCounter.lastFrameTimeInSeconds() );
-		}
+	// Work handed to the main thread by tasks
+		TaskScheduler::instance()->runMainThreadTasks();
+		TaskScheduler::instance()->getProfiler().setEnabled( ts_profile.intValue == 1 );
 
-		Camera::instance()->update();
+	// Systems
+		frameGraph.run();
 
 	// Render
 		Renderer::instance()->drawFrame();
@@ -197,6 +233,7 @@ void Application::run()
 		}
 
 		frameCounter.update();
+		EntityManager::instance()->advanceChangeTick();
 	}
 
 	shutdown();
@@ -209,6 +246,7 @@ void Application::quit()
 
 void Application::shutdown()
 {
+	TaskScheduler::instance()->shutdown();
 	EntityManager::instance()->shutdown();
 
 	Renderer::instance()->shutdown();
@@ -1,6 +1,7 @@
 #pragma once
 #include <memory>
 #include "frameCounter.hpp"
+#include "taskGraph.hpp"
 
 /*
 	Application - This class handles the gameloop, window 
@@ -11,6 +12,9 @@ class Application
 	static std::unique_ptr<Application> _instance;
 
 	FrameCounter		frameCounter;
+	// systems updated every frame between input and rendering
+	TaskGraph			frameGraph;
+	void				buildFrameGraph();
 
 	bool				exitGame;
 	bool				initGLFW();
@@ -47,7 +47,7 @@ void Camera::attachEntity( E_ID who )
 {
 	follows = who;
 
-	TransformComponent* tc = EntityManager::instance()->get<TransformComponent>( follows );
+	const TransformComponent* tc = EntityManager::instance()->getConst<TransformComponent>( follows );
 	if ( tc )
 	{
 		direction = tc->facingDirection;
@@ -58,11 +58,11 @@ void Camera::update()
 {
 	if ( follows != UNSET_ID )
 	{
-		TransformComponent* tc = EntityManager::instance()->get<TransformComponent>( follows );
+		const TransformComponent* tc = EntityManager::instance()->getConst<TransformComponent>( follows );
 		
 		if ( tc )
 		{
-			position = tc->position;
+			position = tc->position + tc->renderOffset;
 			PlayerController::instance()->setFacingDirection( direction );
 		}
 	}
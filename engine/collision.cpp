@@ -0,0 +1,1142 @@
+#include "collision.hpp"
+#include <cmath>
+#include <cfloat>
+#include <cassert>
+#include <numeric>
+#include <algorithm>
+
+#if defined( _M_X64 ) || defined( _M_IX86 ) || defined( __x86_64__ ) || defined( __i386__ )
+#define COLLISION_SIMD
+#include <immintrin.h>
+#if defined( _MSC_VER )
+#include <intrin.h>
+// msvc emits any intrinsic, gcc and clang need the instruction set enabled per function
+#define TARGET_AVX
+#else
+#define TARGET_AVX __attribute__( ( target( "avx" ) ) )
+#endif
+#endif
+
+const float EPSILON = 0.00001f;
+
+// Moller-Trumbore intersection algorithm, the SIMD kernels repeat these exact operations lane wise
+static bool RayTriangleEdges( const glm::vec3& p, const glm::vec3& dir, const glm::vec3& v0,
+	const glm::vec3& edge1, const glm::vec3& edge2, float& t )
+{
+	glm::vec3 h, s, q;
+	float a, f, u, v;
+
+	h = glm::cross( dir, edge2 );
+	a = glm::dot( edge1, h );
+
+	// check if ray is parallel to triangle
+	if ( std::abs( a ) < EPSILON )
+	{
+		return false;
+	}
+
+	f = 1.f / a;
+	s = p - v0;
+	u = f * glm::dot( s, h );
+
+	if ( u < 0.f || u > 1.f )
+	{
+		return false;
+	}
+
+	q = glm::cross( s, edge1 );
+	v = f * glm::dot( dir, q );
+
+	if ( v < 0.f || u + v > 1.f )
+	{
+		return false;
+	}
+
+	t = f * glm::dot( edge2, q );
+	return t > EPSILON;
+}
+
+bool RayTriangleIntersection( const glm::vec3& p, const glm::vec3& dir,
+	const std::array<glm::vec3, 3>& triangle, float& t )
+{
+	return RayTriangleEdges( p, dir, triangle[0], triangle[1] - triangle[0], triangle[2] - triangle[0], t );
+}
+
+bool RayTriangleIntersection( const glm::vec3& p, const glm::vec3& dir,
+	const std::array<glm::vec3, 3>& triangle, glm::vec3& intersectionPoint )
+{
+	float t;
+	if ( RayTriangleIntersection( p, dir, triangle, t ) )
+	{
+		intersectionPoint = p + ( dir * t );
+		return true;
+	}
+
+	return false;
+}
+
+void TriangleBatch::build( const std::vector<std::array<glm::vec3, 3>>& triangles )
+{
+	clear();
+	count = triangles.size();
+
+	for ( std::vector<float>* it : { &v0x, &v0y, &v0z, &e1x, &e1y, &e1z, &e2x, &e2y, &e2z } )
+	{
+		it->resize( count + Padding, 0.f );
+	}
+
+	for ( size_t i = 0; i < count; i++ )
+	{
+		const glm::vec3 edge1 = triangles[i][1] - triangles[i][0];
+		const glm::vec3 edge2 = triangles[i][2] - triangles[i][0];
+
+		v0x[i] = triangles[i][0].x;
+		v0y[i] = triangles[i][0].y;
+		v0z[i] = triangles[i][0].z;
+		e1x[i] = edge1.x;
+		e1y[i] = edge1.y;
+		e1z[i] = edge1.z;
+		e2x[i] = edge2.x;
+		e2y[i] = edge2.y;
+		e2z[i] = edge2.z;
+	}
+}
+
+void TriangleBatch::clear()
+{
+	for ( std::vector<float>* it : { &v0x, &v0y, &v0z, &e1x, &e1y, &e1z, &e2x, &e2y, &e2z } )
+	{
+		it->clear();
+	}
+
+	count = 0;
+}
+
+static bool RayTrianglesScalar( const glm::vec3& p, const glm::vec3& dir, const TriangleBatch& batch,
+	const size_t first, const size_t count, float& closest, uint32_t& index )
+{
+	bool found = false;
+	for ( size_t i = first; i < first + count; i++ )
+	{
+		float t;
+		if ( RayTriangleEdges( p, dir, glm::vec3( batch.v0x[i], batch.v0y[i], batch.v0z[i] ),
+			glm::vec3( batch.e1x[i], batch.e1y[i], batch.e1z[i] ),
+			glm::vec3( batch.e2x[i], batch.e2y[i], batch.e2z[i] ), t ) && t <= closest )
+		{
+			closest = t;
+			index = (uint32_t)i;
+			found = true;
+		}
+	}
+
+	return found;
+}
+
+#ifdef COLLISION_SIMD
+/*
+	The kernels compute every lane with the same operations in the same
+	order as RayTriangleEdges and use the unordered compares where the
+	scalar code rejects with "<" or ">", so NaN lanes end the same way.
+	Hits are then visited in lane order, like the scalar loop does.
+*/
+static bool RayTrianglesSse( const glm::vec3& p, const glm::vec3& dir, const TriangleBatch& batch,
+	const size_t first, const size_t count, float& closest, uint32_t& index )
+{
+	const __m128 px = _mm_set1_ps( p.x ), py = _mm_set1_ps( p.y ), pz = _mm_set1_ps( p.z );
+	const __m128 dx = _mm_set1_ps( dir.x ), dy = _mm_set1_ps( dir.y ), dz = _mm_set1_ps( dir.z );
+	const __m128 epsilon = _mm_set1_ps( EPSILON );
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps( 1.f );
+	const __m128 signBit = _mm_set1_ps( -0.f );
+
+	bool found = false;
+	for ( size_t i = first; i < first + count; i += 4 )
+	{
+		const __m128 e1x = _mm_loadu_ps( &batch.e1x[i] ), e1y = _mm_loadu_ps( &batch.e1y[i] ), e1z = _mm_loadu_ps( &batch.e1z[i] );
+		const __m128 e2x = _mm_loadu_ps( &batch.e2x[i] ), e2y = _mm_loadu_ps( &batch.e2y[i] ), e2z = _mm_loadu_ps( &batch.e2z[i] );
+
+		// h = cross( dir, edge2 ), a = dot( edge1, h )
+		const __m128 hx = _mm_sub_ps( _mm_mul_ps( dy, e2z ), _mm_mul_ps( e2y, dz ) );
+		const __m128 hy = _mm_sub_ps( _mm_mul_ps( dz, e2x ), _mm_mul_ps( e2z, dx ) );
+		const __m128 hz = _mm_sub_ps( _mm_mul_ps( dx, e2y ), _mm_mul_ps( e2x, dy ) );
+		const __m128 a = _mm_add_ps( _mm_add_ps( _mm_mul_ps( e1x, hx ), _mm_mul_ps( e1y, hy ) ), _mm_mul_ps( e1z, hz ) );
+		const __m128 f = _mm_div_ps( one, a );
+
+		// s = p - v0, u = f * dot( s, h )
+		const __m128 sx = _mm_sub_ps( px, _mm_loadu_ps( &batch.v0x[i] ) );
+		const __m128 sy = _mm_sub_ps( py, _mm_loadu_ps( &batch.v0y[i] ) );
+		const __m128 sz = _mm_sub_ps( pz, _mm_loadu_ps( &batch.v0z[i] ) );
+		const __m128 u = _mm_mul_ps( f, _mm_add_ps( _mm_add_ps( _mm_mul_ps( sx, hx ), _mm_mul_ps( sy, hy ) ), _mm_mul_ps( sz, hz ) ) );
+
+		// q = cross( s, edge1 ), v = f * dot( dir, q ), t = f * dot( edge2, q )
+		const __m128 qx = _mm_sub_ps( _mm_mul_ps( sy, e1z ), _mm_mul_ps( e1y, sz ) );
+		const __m128 qy = _mm_sub_ps( _mm_mul_ps( sz, e1x ), _mm_mul_ps( e1z, sx ) );
+		const __m128 qz = _mm_sub_ps( _mm_mul_ps( sx, e1y ), _mm_mul_ps( e1x, sy ) );
+		const __m128 v = _mm_mul_ps( f, _mm_add_ps( _mm_add_ps( _mm_mul_ps( dx, qx ), _mm_mul_ps( dy, qy ) ), _mm_mul_ps( dz, qz ) ) );
+		const __m128 t = _mm_mul_ps( f, _mm_add_ps( _mm_add_ps( _mm_mul_ps( e2x, qx ), _mm_mul_ps( e2y, qy ) ), _mm_mul_ps( e2z, qz ) ) );
+
+		__m128 mask = _mm_cmpnlt_ps( _mm_andnot_ps( signBit, a ), epsilon );
+		mask = _mm_and_ps( mask, _mm_and_ps( _mm_cmpnlt_ps( u, zero ), _mm_cmpngt_ps( u, one ) ) );
+		mask = _mm_and_ps( mask, _mm_and_ps( _mm_cmpnlt_ps( v, zero ), _mm_cmpngt_ps( _mm_add_ps( u, v ), one ) ) );
+		mask = _mm_and_ps( mask, _mm_cmpgt_ps( t, epsilon ) );
+
+		// lanes past the range hold the next triangles or the padding
+		const size_t lanes = std::min<size_t>( first + count - i, 4 );
+		int hits = _mm_movemask_ps( mask ) & ( ( 1 << lanes ) - 1 );
+		if ( hits == 0 )
+		{
+			continue;
+		}
+
+		alignas( 16 ) float distances[4];
+		_mm_store_ps( distances, t );
+		for ( size_t lane = 0; lane < lanes; lane++ )
+		{
+			if ( ( hits & ( 1 << lane ) ) && distances[lane] <= closest )
+			{
+				closest = distances[lane];
+				index = (uint32_t)( i + lane );
+				found = true;
+			}
+		}
+	}
+
+	return found;
+}
+
+TARGET_AVX static bool RayTrianglesAvx( const glm::vec3& p, const glm::vec3& dir, const TriangleBatch& batch,
+	const size_t first, const size_t count, float& closest, uint32_t& index )
+{
+	const __m256 px = _mm256_set1_ps( p.x ), py = _mm256_set1_ps( p.y ), pz = _mm256_set1_ps( p.z );
+	const __m256 dx = _mm256_set1_ps( dir.x ), dy = _mm256_set1_ps( dir.y ), dz = _mm256_set1_ps( dir.z );
+	const __m256 epsilon = _mm256_set1_ps( EPSILON );
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps( 1.f );
+	const __m256 signBit = _mm256_set1_ps( -0.f );
+
+	bool found = false;
+	for ( size_t i = first; i < first + count; i += 8 )
+	{
+		const __m256 e1x = _mm256_loadu_ps( &batch.e1x[i] ), e1y = _mm256_loadu_ps( &batch.e1y[i] ), e1z = _mm256_loadu_ps( &batch.e1z[i] );
+		const __m256 e2x = _mm256_loadu_ps( &batch.e2x[i] ), e2y = _mm256_loadu_ps( &batch.e2y[i] ), e2z = _mm256_loadu_ps( &batch.e2z[i] );
+
+		const __m256 hx = _mm256_sub_ps( _mm256_mul_ps( dy, e2z ), _mm256_mul_ps( e2y, dz ) );
+		const __m256 hy = _mm256_sub_ps( _mm256_mul_ps( dz, e2x ), _mm256_mul_ps( e2z, dx ) );
+		const __m256 hz = _mm256_sub_ps( _mm256_mul_ps( dx, e2y ), _mm256_mul_ps( e2x, dy ) );
+		const __m256 a = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( e1x, hx ), _mm256_mul_ps( e1y, hy ) ), _mm256_mul_ps( e1z, hz ) );
+		const __m256 f = _mm256_div_ps( one, a );
+
+		const __m256 sx = _mm256_sub_ps( px, _mm256_loadu_ps( &batch.v0x[i] ) );
+		const __m256 sy = _mm256_sub_ps( py, _mm256_loadu_ps( &batch.v0y[i] ) );
+		const __m256 sz = _mm256_sub_ps( pz, _mm256_loadu_ps( &batch.v0z[i] ) );
+		const __m256 u = _mm256_mul_ps( f, _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( sx, hx ), _mm256_mul_ps( sy, hy ) ), _mm256_mul_ps( sz, hz ) ) );
+
+		const __m256 qx = _mm256_sub_ps( _mm256_mul_ps( sy, e1z ), _mm256_mul_ps( e1y, sz ) );
+		const __m256 qy = _mm256_sub_ps( _mm256_mul_ps( sz, e1x ), _mm256_mul_ps( e1z, sx ) );
+		const __m256 qz = _mm256_sub_ps( _mm256_mul_ps( sx, e1y ), _mm256_mul_ps( e1x, sy ) );
+		const __m256 v = _mm256_mul_ps( f, _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( dx, qx ), _mm256_mul_ps( dy, qy ) ), _mm256_mul_ps( dz, qz ) ) );
+		const __m256 t = _mm256_mul_ps( f, _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( e2x, qx ), _mm256_mul_ps( e2y, qy ) ), _mm256_mul_ps( e2z, qz ) ) );
+
+		__m256 mask = _mm256_cmp_ps( _mm256_andnot_ps( signBit, a ), epsilon, _CMP_NLT_UQ );
+		mask = _mm256_and_ps( mask, _mm256_and_ps( _mm256_cmp_ps( u, zero, _CMP_NLT_UQ ), _mm256_cmp_ps( u, one, _CMP_NGT_UQ ) ) );
+		mask = _mm256_and_ps( mask, _mm256_and_ps( _mm256_cmp_ps( v, zero, _CMP_NLT_UQ ),
+			_mm256_cmp_ps( _mm256_add_ps( u, v ), one, _CMP_NGT_UQ ) ) );
+		mask = _mm256_and_ps( mask, _mm256_cmp_ps( t, epsilon, _CMP_GT_OQ ) );
+
+		const size_t lanes = std::min<size_t>( first + count - i, 8 );
+		int hits = _mm256_movemask_ps( mask ) & ( ( 1 << lanes ) - 1 );
+		if ( hits == 0 )
+		{
+			continue;
+		}
+
+		alignas( 32 ) float distances[8];
+		_mm256_store_ps( distances, t );
+		for ( size_t lane = 0; lane < lanes; lane++ )
+		{
+			if ( ( hits & ( 1 << lane ) ) && distances[lane] <= closest )
+			{
+				closest = distances[lane];
+				index = (uint32_t)( i + lane );
+				found = true;
+			}
+		}
+	}
+
+	return found;
+}
+#endif
+
+enu_SIMD_LEVEL DetectSimdLevel()
+{
+	static const enu_SIMD_LEVEL level = []()
+	{
+#if defined( COLLISION_SIMD ) && defined( _MSC_VER )
+		int info[4];
+		__cpuid( info, 1 );
+		// avx needs the os to save the ymm registers too (osxsave + xcr0)
+		const bool osxsave = ( info[2] & ( 1 << 27 ) ) != 0;
+		const bool avx = ( info[2] & ( 1 << 28 ) ) != 0;
+		if ( osxsave && avx && ( _xgetbv( 0 ) & 0x6 ) == 0x6 )
+		{
+			return enu_SIMD_LEVEL::avx;
+		}
+
+		return ( info[3] & ( 1 << 25 ) ) != 0 ? enu_SIMD_LEVEL::sse : enu_SIMD_LEVEL::scalar;
+#elif defined( COLLISION_SIMD )
+		if ( __builtin_cpu_supports( "avx" ) )
+		{
+			return enu_SIMD_LEVEL::avx;
+		}
+
+		return __builtin_cpu_supports( "sse" ) ? enu_SIMD_LEVEL::sse : enu_SIMD_LEVEL::scalar;
+#else
+		return enu_SIMD_LEVEL::scalar;
+#endif
+	}();
+
+	return level;
+}
+
+bool RayTrianglesIntersection( const glm::vec3& p, const glm::vec3& dir, const TriangleBatch& batch,
+	const size_t first, const size_t count, float& closest, uint32_t& index, const enu_SIMD_LEVEL level )
+{
+	assert( first + count <= batch.size() );
+
+#ifdef COLLISION_SIMD
+	switch ( level )
+	{
+		case enu_SIMD_LEVEL::avx: return RayTrianglesAvx( p, dir, batch, first, count, closest, index );
+		case enu_SIMD_LEVEL::sse: return RayTrianglesSse( p, dir, batch, first, count, closest, index );
+		default: break;
+	}
+#endif
+
+	return RayTrianglesScalar( p, dir, batch, first, count, closest, index );
+}
+
+bool RayTrianglesIntersection( const glm::vec3& p, const glm::vec3& dir, const TriangleBatch& batch,
+	const size_t first, const size_t count, float& closest, uint32_t& index )
+{
+	static const enu_SIMD_LEVEL level = DetectSimdLevel();
+	return RayTrianglesIntersection( p, dir, batch, first, count, closest, index, level );
+}
+
+// Ericson, Real-Time Collision Detection 5.1.5
+static glm::vec3 ClosestPointOnTriangle( const glm::vec3& p, const glm::vec3& a, const glm::vec3& b,
+	const glm::vec3& c )
+{
+	const glm::vec3 ab = b - a;
+	const glm::vec3 ac = c - a;
+	const glm::vec3 ap = p - a;
+	const float d1 = glm::dot( ab, ap );
+	const float d2 = glm::dot( ac, ap );
+	if ( d1 <= 0.f && d2 <= 0.f )
+	{
+		return a;
+	}
+
+	const glm::vec3 bp = p - b;
+	const float d3 = glm::dot( ab, bp );
+	const float d4 = glm::dot( ac, bp );
+	if ( d3 >= 0.f && d4 <= d3 )
+	{
+		return b;
+	}
+
+	const float vc = d1 * d4 - d3 * d2;
+	if ( vc <= 0.f && d1 >= 0.f && d3 <= 0.f )
+	{
+		return a + ab * ( d1 / ( d1 - d3 ) );
+	}
+
+	const glm::vec3 cp = p - c;
+	const float d5 = glm::dot( ab, cp );
+	const float d6 = glm::dot( ac, cp );
+	if ( d6 >= 0.f && d5 <= d6 )
+	{
+		return c;
+	}
+
+	const float vb = d5 * d2 - d1 * d6;
+	if ( vb <= 0.f && d2 >= 0.f && d6 <= 0.f )
+	{
+		return a + ac * ( d2 / ( d2 - d6 ) );
+	}
+
+	const float va = d3 * d6 - d5 * d4;
+	if ( va <= 0.f && ( d4 - d3 ) >= 0.f && ( d5 - d6 ) >= 0.f )
+	{
+		return b + ( c - b ) * ( ( d4 - d3 ) / ( ( d4 - d3 ) + ( d5 - d6 ) ) );
+	}
+
+	const float denom = 1.f / ( va + vb + vc );
+	return a + ab * ( vb * denom ) + ac * ( vc * denom );
+}
+
+// p is in the triangle's plane, barycentric test
+static bool PointInTriangle( const glm::vec3& p, const std::array<glm::vec3, 3>& triangle )
+{
+	const glm::vec3 e0 = triangle[1] - triangle[0];
+	const glm::vec3 e1 = triangle[2] - triangle[0];
+	const glm::vec3 w = p - triangle[0];
+
+	const float d00 = glm::dot( e0, e0 );
+	const float d01 = glm::dot( e0, e1 );
+	const float d11 = glm::dot( e1, e1 );
+	const float d20 = glm::dot( w, e0 );
+	const float d21 = glm::dot( w, e1 );
+	const float denom = d00 * d11 - d01 * d01;
+
+	const float v = ( d11 * d20 - d01 * d21 ) / denom;
+	const float u = ( d00 * d21 - d01 * d20 ) / denom;
+	return v >= 0.f && u >= 0.f && u + v <= 1.f;
+}
+
+// smallest root of a t^2 + b t + c = 0 in [0, 1]
+static bool LowestRoot( const float a, const float b, const float c, float& root )
+{
+	const float discriminant = b * b - 4.f * a * c;
+	if ( discriminant < 0.f || std::abs( a ) < 1e-12f )
+	{
+		return false;
+	}
+
+	const float t = ( -b - std::sqrt( discriminant ) ) / ( 2.f * a );
+	if ( t < 0.f || t > 1.f )
+	{
+		return false;
+	}
+
+	root = t;
+	return true;
+}
+
+bool SweepSphereTriangle( const glm::vec3& center, const float radius, const glm::vec3& motion,
+	const std::array<glm::vec3, 3>& triangle, SweepHit& hit )
+{
+	// already touching, only moving towards the triangle is blocked
+	const glm::vec3 closest = ClosestPointOnTriangle( center, triangle[0], triangle[1], triangle[2] );
+	const glm::vec3 away = center - closest;
+	if ( glm::dot( away, away ) < radius * radius )
+	{
+		if ( glm::dot( away, motion ) >= 0.f || glm::dot( away, away ) <= 0.f )
+		{
+			return false;
+		}
+
+		hit.time = 0.f;
+		hit.normal = glm::normalize( away );
+		hit.point = closest;
+		return true;
+	}
+
+	bool found = false;
+	float best = 1.f;
+	glm::vec3 contact;
+
+	// the face: the sphere touches the plane first, the contact is the point under the center
+	glm::vec3 normal = glm::cross( triangle[1] - triangle[0], triangle[2] - triangle[0] );
+	if ( glm::length( normal ) > 0.f )
+	{
+		normal = glm::normalize( normal );
+		float distance = glm::dot( normal, center - triangle[0] );
+		if ( distance < 0.f )
+		{
+			normal = -normal;
+			distance = -distance;
+		}
+
+		const float approach = -glm::dot( normal, motion );
+		if ( approach > 0.f )
+		{
+			const float t = ( distance - radius ) / approach;
+			const glm::vec3 onPlane = center + motion * t - normal * radius;
+			if ( t >= 0.f && t <= 1.f && PointInTriangle( onPlane, triangle ) )
+			{
+				// nothing on the edges can come earlier than the face
+				hit.time = t;
+				hit.normal = normal;
+				hit.point = onPlane;
+				return true;
+			}
+		}
+	}
+
+	// the corners, |center + motion t - v| = radius
+	const float motionSq = glm::dot( motion, motion );
+	for ( const glm::vec3& v : triangle )
+	{
+		const glm::vec3 w = center - v;
+		float t;
+		if ( LowestRoot( motionSq, 2.f * glm::dot( motion, w ), glm::dot( w, w ) - radius * radius, t ) && t <= best )
+		{
+			best = t;
+			contact = v;
+			found = true;
+		}
+	}
+
+	// the edges, the distance from the center to the edge's line is radius
+	for ( int i = 0; i < 3; i++ )
+	{
+		const glm::vec3& p0 = triangle[i];
+		const glm::vec3 edge = triangle[( i + 1 ) % 3] - p0;
+		const glm::vec3 w = center - p0;
+
+		const float edgeSq = glm::dot( edge, edge );
+		const float edgeMotion = glm::dot( edge, motion );
+		const float edgeW = glm::dot( edge, w );
+
+		float t;
+		if ( LowestRoot( edgeSq * motionSq - edgeMotion * edgeMotion,
+			2.f * ( edgeSq * glm::dot( motion, w ) - edgeMotion * edgeW ),
+			edgeSq * ( glm::dot( w, w ) - radius * radius ) - edgeW * edgeW, t ) && t <= best )
+		{
+			// the line is hit, the segment only between its ends
+			const float f = ( edgeW + edgeMotion * t ) / edgeSq;
+			if ( f >= 0.f && f <= 1.f )
+			{
+				best = t;
+				contact = p0 + edge * f;
+				found = true;
+			}
+		}
+	}
+
+	if ( found )
+	{
+		hit.time = best;
+		hit.normal = glm::normalize( center + motion * best - contact );
+		hit.point = contact;
+	}
+
+	return found;
+}
+
+static float SurfaceArea( const glm::vec3& boundsMin, const glm::vec3& boundsMax )
+{
+	const glm::vec3 e = boundsMax - boundsMin;
+	return 2.f * ( e.x * e.y + e.y * e.z + e.z * e.x );
+}
+
+// distance where the ray enters the node's box grown by expand, FLT_MAX if it misses it within maxDistance
+static float RayBoxDistance( const glm::vec3& origin, const glm::vec3& invDir, const BVHNode& node,
+	const float maxDistance, const float expand )
+{
+	glm::vec3 t0 = ( node.boundsMin - glm::vec3( expand ) - origin ) * invDir;
+	glm::vec3 t1 = ( node.boundsMax + glm::vec3( expand ) - origin ) * invDir;
+
+	// parallel to a slab and starting on one of its planes is 0 * inf = NaN, 
+	// the ray stays inside that slab so the axis must not limit the interval
+	for ( int i = 0; i < 3; i++ )
+	{
+		if ( std::isnan( t0[i] ) || std::isnan( t1[i] ) )
+		{
+			t0[i] = -FLT_MAX;
+			t1[i] = FLT_MAX;
+		}
+	}
+
+	const glm::vec3 tNear = glm::min( t0, t1 );
+	const glm::vec3 tFar = glm::max( t0, t1 );
+
+	const float enter = std::max( std::max( tNear.x, tNear.y ), std::max( tNear.z, 0.f ) );
+	const float exit = std::min( std::min( tFar.x, tFar.y ), std::min( tFar.z, maxDistance ) );
+
+	return enter <= exit ? enter : FLT_MAX;
+}
+
+void BVH::clear()
+{
+	nodes.clear();
+	triangles.clear();
+	triangleIndices.clear();
+}
+
+void BVH::build( const std::vector<std::array<glm::vec3, 3>>& input )
+{
+	clear();
+	if ( input.empty() )
+	{
+		return;
+	}
+
+	// the build only looks at the boxes of the triangles
+	std::vector<glm::vec3> centroids( input.size() );
+	std::vector<glm::vec3> boundsMin( input.size() );
+	std::vector<glm::vec3> boundsMax( input.size() );
+	for ( size_t i = 0; i < input.size(); i++ )
+	{
+		boundsMin[i] = glm::min( glm::min( input[i][0], input[i][1] ), input[i][2] );
+		boundsMax[i] = glm::max( glm::max( input[i][0], input[i][1] ), input[i][2] );
+		centroids[i] = ( boundsMin[i] + boundsMax[i] ) * 0.5f;
+	}
+
+	triangleIndices.resize( input.size() );
+	std::iota( triangleIndices.begin(), triangleIndices.end(), 0 );
+
+	// a binary tree with n leaves at most has 2n - 1 nodes, the references in buildNode stay valid
+	nodes.reserve( input.size() * 2 );
+	nodes.emplace_back();
+	buildNode( 0, 0, input.size(), 0, centroids, boundsMin, boundsMax );
+	nodes.shrink_to_fit();
+
+	std::vector<std::array<glm::vec3, 3>> ordered;
+	ordered.reserve( input.size() );
+	for ( const uint32_t index : triangleIndices )
+	{
+		ordered.push_back( input[index] );
+	}
+
+	triangles.build( ordered );
+}
+
+void BVH::buildNode( const size_t nodeIndex, const size_t first, const size_t count, const size_t depth,
+	const std::vector<glm::vec3>& centroids, const std::vector<glm::vec3>& boundsMin,
+	const std::vector<glm::vec3>& boundsMax )
+{
+	BVHNode& node = nodes[nodeIndex];
+
+	glm::vec3 centroidMin( FLT_MAX );
+	glm::vec3 centroidMax( -FLT_MAX );
+	node.boundsMin = glm::vec3( FLT_MAX );
+	node.boundsMax = glm::vec3( -FLT_MAX );
+	for ( size_t i = first; i < first + count; i++ )
+	{
+		const uint32_t index = triangleIndices[i];
+		node.boundsMin = glm::min( node.boundsMin, boundsMin[index] );
+		node.boundsMax = glm::max( node.boundsMax, boundsMax[index] );
+		centroidMin = glm::min( centroidMin, centroids[index] );
+		centroidMax = glm::max( centroidMax, centroids[index] );
+	}
+
+	node.offset = (uint32_t)first;
+	node.count = (uint32_t)count;
+
+	if ( count <= MinLeafSize || depth >= MaxDepth )
+	{
+		return;
+	}
+
+	struct Bin
+	{
+		glm::vec3	boundsMin = glm::vec3( FLT_MAX );
+		glm::vec3	boundsMax = glm::vec3( -FLT_MAX );
+		size_t		count = 0;
+	};
+
+	float bestCost = FLT_MAX;
+	int bestAxis = -1;
+	size_t bestSplit = 0;
+
+	for ( int axis = 0; axis < 3; axis++ )
+	{
+		const float extent = centroidMax[axis] - centroidMin[axis];
+		if ( extent <= 0.f )
+		{
+			continue;
+		}
+
+		const float scale = BinCount / extent;
+		std::array<Bin, BinCount> bins;
+		for ( size_t i = first; i < first + count; i++ )
+		{
+			const uint32_t index = triangleIndices[i];
+			Bin& bin = bins[std::min( (size_t)( ( centroids[index][axis] - centroidMin[axis] ) * scale ), BinCount - 1 )];
+			bin.boundsMin = glm::min( bin.boundsMin, boundsMin[index] );
+			bin.boundsMax = glm::max( bin.boundsMax, boundsMax[index] );
+			bin.count++;
+		}
+
+		// sweep from the right first, then evaluate every split plane from the left
+		std::array<float, BinCount> rightArea;
+		std::array<size_t, BinCount> rightCount;
+		Bin right;
+		for ( size_t b = BinCount - 1; b > 0; b-- )
+		{
+			right.boundsMin = glm::min( right.boundsMin, bins[b].boundsMin );
+			right.boundsMax = glm::max( right.boundsMax, bins[b].boundsMax );
+			right.count += bins[b].count;
+			rightArea[b] = SurfaceArea( right.boundsMin, right.boundsMax );
+			rightCount[b] = right.count;
+		}
+
+		Bin left;
+		for ( size_t b = 0; b < BinCount - 1; b++ )
+		{
+			left.boundsMin = glm::min( left.boundsMin, bins[b].boundsMin );
+			left.boundsMax = glm::max( left.boundsMax, bins[b].boundsMax );
+			left.count += bins[b].count;
+
+			if ( left.count == 0 || rightCount[b + 1] == 0 )
+			{
+				continue;
+			}
+
+			const float cost = SurfaceArea( left.boundsMin, left.boundsMax ) * left.count +
+				rightArea[b + 1] * rightCount[b + 1];
+			if ( cost < bestCost )
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = b;
+			}
+		}
+	}
+
+	size_t leftCount;
+	if ( bestAxis == -1 )
+	{
+		// every centroid is in the same spot, no plane separates them
+		if ( count <= MaxLeafSize )
+		{
+			return;
+		}
+
+		leftCount = count / 2;
+	}
+	else
+	{
+		// a traversal step costs about as much as one triangle test
+		const float nodeArea = SurfaceArea( node.boundsMin, node.boundsMax );
+		if ( count <= MaxLeafSize && nodeArea + bestCost >= nodeArea * count )
+		{
+			return;
+		}
+
+		const float scale = BinCount / ( centroidMax[bestAxis] - centroidMin[bestAxis] );
+		const float splitMin = centroidMin[bestAxis];
+		auto middle = std::partition( triangleIndices.begin() + first, triangleIndices.begin() + first + count,
+			[&]( const uint32_t index )
+		{
+			return std::min( (size_t)( ( centroids[index][bestAxis] - splitMin ) * scale ), BinCount - 1 ) <= bestSplit;
+		} );
+
+		leftCount = middle - ( triangleIndices.begin() + first );
+	}
+
+	// depth first: the left child follows its parent, the parent points at the right one
+	nodes.emplace_back();
+	buildNode( nodeIndex + 1, first, leftCount, depth + 1, centroids, boundsMin, boundsMax );
+
+	const size_t rightIndex = nodes.size();
+	nodes.emplace_back();
+	nodes[nodeIndex].offset = (uint32_t)rightIndex;
+	nodes[nodeIndex].count = 0;
+	buildNode( rightIndex, first + leftCount, count - leftCount, depth + 1, centroids, boundsMin, boundsMax );
+}
+
+template <typename LeafFn> void BVH::traverse( const glm::vec3& origin, const glm::vec3& dir, const float expand,
+	float& closest, LeafFn&& leaf ) const
+{
+	if ( nodes.empty() )
+	{
+		return;
+	}
+
+	struct Entry
+	{
+		uint32_t	node;
+		float		distance;
+	};
+
+	// the depth is capped while building, so is the number of deferred siblings
+	std::array<Entry, MaxDepth + 1> stack;
+	size_t stackSize = 0;
+
+	const glm::vec3 invDir = 1.f / dir;
+
+	if ( RayBoxDistance( origin, invDir, nodes[0], closest, expand ) != FLT_MAX )
+	{
+		stack[stackSize++] = { 0, 0.f };
+	}
+
+	while ( stackSize > 0 )
+	{
+		const Entry entry = stack[--stackSize];
+		// something closer was found since the node was pushed
+		if ( entry.distance > closest )
+		{
+			continue;
+		}
+
+		uint32_t current = entry.node;
+		while ( true )
+		{
+			const BVHNode& node = nodes[current];
+			if ( node.count > 0 )
+			{
+				leaf( node );
+				break;
+			}
+
+			// visit the nearer child first, the other one waits on the stack
+			uint32_t nearChild = current + 1;
+			uint32_t farChild = node.offset;
+			float nearDistance = RayBoxDistance( origin, invDir, nodes[nearChild], closest, expand );
+			float farDistance = RayBoxDistance( origin, invDir, nodes[farChild], closest, expand );
+			if ( farDistance < nearDistance )
+			{
+				std::swap( nearChild, farChild );
+				std::swap( nearDistance, farDistance );
+			}
+
+			if ( nearDistance == FLT_MAX )
+			{
+				break;
+			}
+
+			if ( farDistance != FLT_MAX )
+			{
+				stack[stackSize++] = { farChild, farDistance };
+			}
+
+			current = nearChild;
+		}
+	}
+}
+
+bool BVH::intersect( const glm::vec3& origin, const glm::vec3& dir, const float maxDistance,
+	RayHit& hit ) const
+{
+	float closest = maxDistance;
+	bool found = false;
+
+	traverse( origin, dir, 0.f, closest, [&]( const BVHNode& node )
+	{
+		uint32_t index;
+		if ( RayTrianglesIntersection( origin, dir, triangles, node.offset, node.count, closest, index ) )
+		{
+			hit.triangle = triangleIndices[index];
+			found = true;
+		}
+	} );
+
+	if ( found )
+	{
+		hit.distance = closest;
+		hit.point = origin + dir * closest;
+	}
+
+	return found;
+}
+
+bool BVH::sweepSphere( const glm::vec3& center, const float radius, const glm::vec3& motion,
+	SweepHit& hit ) const
+{
+	if ( glm::length( motion ) <= 0.f )
+	{
+		return false;
+	}
+
+	// the motion is the ray, times run 0 to 1 over it
+	float closest = 1.f;
+	bool found = false;
+
+	traverse( center, motion, radius, closest, [&]( const BVHNode& node )
+	{
+		for ( uint32_t i = node.offset; i < node.offset + node.count; i++ )
+		{
+			const glm::vec3 v0( triangles.v0x[i], triangles.v0y[i], triangles.v0z[i] );
+			const std::array<glm::vec3, 3> triangle = { v0,
+				v0 + glm::vec3( triangles.e1x[i], triangles.e1y[i], triangles.e1z[i] ),
+				v0 + glm::vec3( triangles.e2x[i], triangles.e2y[i], triangles.e2z[i] ) };
+
+			SweepHit candidate;
+			if ( SweepSphereTriangle( center, radius, motion, triangle, candidate ) && candidate.time <= closest )
+			{
+				closest = candidate.time;
+				hit = candidate;
+				hit.triangle = triangleIndices[i];
+				found = true;
+			}
+		}
+	} );
+
+	return found;
+}
+
+bool BVH::sweepCapsule( const glm::vec3& a, const glm::vec3& b, const float radius, const glm::vec3& motion,
+	SweepHit& hit ) const
+{
+	// spheres one radius apart along the segment, the surface between them dips in by 
+	// at most 0.13 radius, close enough for characters and far cheaper than an exact capsule
+	const int spheres = 1 + (int)std::ceil( glm::length( b - a ) / std::max( radius, 0.001f ) );
+
+	bool found = false;
+	for ( int i = 0; i < spheres; i++ )
+	{
+		const float f = spheres == 1 ? 0.f : (float)i / ( spheres - 1 );
+
+		SweepHit candidate;
+		if ( sweepSphere( a + ( b - a ) * f, radius, motion, candidate ) && ( !found || candidate.time < hit.time ) )
+		{
+			hit = candidate;
+			found = true;
+		}
+	}
+
+	return found;
+}
+
+// part of motion the capsule can cover before it touches something, a skin short of the contact
+static glm::vec3 ClipMotion( const glm::vec3& motion, const SweepHit& hit )
+{
+	const float length = glm::length( motion );
+	return motion * ( std::max( length * hit.time - BVH::SkinWidth, 0.f ) / length );
+}
+
+bool BVH::stepCapsule( const glm::vec3& a, const glm::vec3& b, const float radius, const glm::vec3& motion,
+	const float stepHeight, glm::vec3& moved, SweepHit& ground ) const
+{
+	const glm::vec3 across( motion.x, 0.f, motion.z );
+	if ( glm::length( across ) < 0.0001f )
+	{
+		return false;
+	}
+
+	SweepHit hit;
+
+	// as high as the ceiling allows
+	glm::vec3 up( 0.f, stepHeight, 0.f );
+	if ( sweepCapsule( a, b, radius, up, hit ) )
+	{
+		up = ClipMotion( up, hit );
+	}
+
+	// still blocked up there, it is a wall and not a step
+	glm::vec3 forward = across;
+	if ( sweepCapsule( a + up, b + up, radius, forward, hit ) )
+	{
+		forward = ClipMotion( forward, hit );
+	}
+	if ( glm::length( forward ) < 0.0001f )
+	{
+		return false;
+	}
+
+	// down onto the step, at most back to the height it started from
+	const glm::vec3 raised = up + forward;
+	const glm::vec3 down( 0.f, -up.y, 0.f );
+	if ( up.y <= 0.f || !sweepCapsule( a + raised, b + raised, radius, down, ground ) || 
+		ground.normal.y < WalkableNormalY )
+	{
+		return false;
+	}
+
+	moved = raised + ClipMotion( down, ground );
+	return true;
+}
+
+bool BVH::slideCapsule( const glm::vec3& a, const glm::vec3& b, const float radius, const glm::vec3& motion,
+	glm::vec3& moved, SweepHit& firstHit, glm::vec3* velocity, const float stepHeight ) const
+{
+	moved = glm::vec3( 0.f );
+	glm::vec3 remaining = motion;
+	bool found = false;
+
+	for ( int i = 0; i < MaxSlideIterations && glm::length( remaining ) > 0.0001f; i++ )
+	{
+		SweepHit hit;
+		if ( !sweepCapsule( a + moved, b + moved, radius, remaining, hit ) )
+		{
+			moved += remaining;
+			break;
+		}
+
+		const glm::vec3 advance = ClipMotion( remaining, hit );
+		moved += advance;
+		remaining -= advance;
+
+		// a wall low enough to climb, the rest of the motion ends standing on the step
+		glm::vec3 stepped;
+		SweepHit ground;
+		if ( stepHeight > 0.f && std::abs( hit.normal.y ) < WalkableNormalY && 
+			stepCapsule( a + moved, b + moved, radius, remaining, stepHeight, stepped, ground ) )
+		{
+			moved += stepped;
+			remaining = glm::vec3( 0.f );
+			hit = ground;
+		}
+		else
+		{
+			// keep the part of the rest that runs along the surface
+			remaining -= hit.normal * glm::dot( remaining, hit.normal );
+		}
+
+		// moving away from the surface is fine, into it is not
+		if ( velocity != nullptr )
+		{
+			*velocity -= hit.normal * std::min( glm::dot( *velocity, hit.normal ), 0.f );
+		}
+
+		if ( !found )
+		{
+			firstHit = hit;
+			found = true;
+		}
+	}
+
+	return found;
+}
+
+static uint32_t HashCell( const int x, const int y, const int z, const uint32_t mask )
+{
+	return ( ( (uint32_t)x * 73856093u ) ^ ( (uint32_t)y * 19349663u ) ^ ( (uint32_t)z * 83492791u ) ) & mask;
+}
+
+void SpatialHashGrid::findPairs( std::vector<BodyPair>& pairs )
+{
+	if ( bodies.size() < 2 )
+	{
+		return;
+	}
+
+	float size = cellSize;
+	if ( size <= 0.f )
+	{
+		float extents = 0.f;
+		for ( const Body& body : bodies )
+		{
+			const glm::vec3 e = body.boundsMax - body.boundsMin;
+			extents += std::max( std::max( e.x, e.y ), e.z );
+		}
+
+		size = std::max( 2.f * extents / bodies.size(), 0.001f );
+	}
+
+	const float invSize = 1.f / size;
+	auto cell = [invSize]( const float p )
+	{
+		// written so nan ends up in the lowest cell too
+		const float c = std::floor( p * invSize );
+		return c >= (float)CellLimit ? CellLimit : c > (float)-CellLimit ? (int)c : -CellLimit;
+	};
+
+	auto overlaps = []( const Body& a, const Body& b )
+	{
+		return !( a.boundsMax.x < b.boundsMin.x || b.boundsMax.x < a.boundsMin.x ||
+			a.boundsMax.y < b.boundsMin.y || b.boundsMax.y < a.boundsMin.y ||
+			a.boundsMax.z < b.boundsMin.z || b.boundsMax.z < a.boundsMin.z );
+	};
+
+	// a table about twice the number of bodies keeps the buckets short
+	uint32_t tableSize = 64;
+	while ( tableSize < bodies.size() * 2 )
+	{
+		tableSize *= 2;
+	}
+
+	const uint32_t mask = tableSize - 1;
+
+	entryHashes.clear();
+	oversized.clear();
+	cellStart.assign( tableSize + 1, 0 );
+	for ( uint32_t i = 0; i < bodies.size(); i++ )
+	{
+		const Body& body = bodies[i];
+		const int x0 = cell( body.boundsMin.x ), x1 = cell( body.boundsMax.x );
+		const int y0 = cell( body.boundsMin.y ), y1 = cell( body.boundsMax.y );
+		const int z0 = cell( body.boundsMin.z ), z1 = cell( body.boundsMax.z );
+
+		// the clamp keeps the product in range, an inverted box touches no cell at all
+		const int64_t cells = std::max<int64_t>( x1 - x0 + 1, 0 ) * std::max<int64_t>( y1 - y0 + 1, 0 ) * 
+			std::max<int64_t>( z1 - z0 + 1, 0 );
+		if ( cells > MaxCellsPerBody )
+		{
+			oversized.push_back( i );
+			entryHashes.push_back( UINT32_MAX );
+			continue;
+		}
+
+		for ( int x = x0; x <= x1; x++ )
+		{
+			for ( int y = y0; y <= y1; y++ )
+			{
+				for ( int z = z0; z <= z1; z++ )
+				{
+					const uint32_t hash = HashCell( x, y, z, mask );
+					entryHashes.push_back( hash );
+					cellStart[hash + 1]++;
+				}
+			}
+		}
+
+		// ends the body's entries, the sort pass doesn't need to repeat the cell math
+		entryHashes.push_back( UINT32_MAX );
+	}
+
+	for ( uint32_t h = 0; h < tableSize; h++ )
+	{
+		cellStart[h + 1] += cellStart[h];
+	}
+
+	// the entries were made body by body, so every bucket lists its bodies in ascending order
+	cellBodies.resize( cellStart[tableSize] );
+	cursor.assign( cellStart.begin(), cellStart.end() - 1 );
+	uint32_t body = 0;
+	for ( const uint32_t hash : entryHashes )
+	{
+		if ( hash == UINT32_MAX )
+		{
+			body++;
+			continue;
+		}
+
+		cellBodies[cursor[hash]++] = body;
+	}
+
+	for ( uint32_t h = 0; h < tableSize; h++ )
+	{
+		const uint32_t begin = cellStart[h];
+		const uint32_t end = cellStart[h + 1];
+
+		for ( uint32_t i = begin; i < end; i++ )
+		{
+			// a body spanning cells that hash alike is in the bucket more than once
+			if ( i > begin && cellBodies[i] == cellBodies[i - 1] )
+			{
+				continue;
+			}
+
+			const Body& a = bodies[cellBodies[i]];
+			for ( uint32_t j = i + 1; j < end; j++ )
+			{
+				if ( cellBodies[j] == cellBodies[j - 1] )
+				{
+					continue;
+				}
+
+				if ( !overlaps( a, bodies[cellBodies[j]] ) )
+				{
+					continue;
+				}
+
+				// only the cell owning the overlap's minimum corner reports the pair
+				const glm::vec3 overlap = glm::max( a.boundsMin, bodies[cellBodies[j]].boundsMin );
+				if ( HashCell( cell( overlap.x ), cell( overlap.y ), cell( overlap.z ), mask ) == h )
+				{
+					pairs.push_back( { cellBodies[i], cellBodies[j] } );
+				}
+			}
+		}
+	}
+
+	// the few bodies left out of the table against everything, a pair of them once
+	for ( size_t i = 0; i < oversized.size(); i++ )
+	{
+		const uint32_t big = oversized[i];
+		for ( uint32_t other = 0; other < bodies.size(); other++ )
+		{
+			// the list is ascending, pairs with the ones before this came out of their own pass
+			if ( other == big || !overlaps( bodies[big], bodies[other] ) || 
+				std::binary_search( oversized.begin(), oversized.begin() + i, other ) )
+			{
+				continue;
+			}
+
+			pairs.push_back( big < other ? BodyPair{ big, other } : BodyPair{ other, big } );
+		}
+	}
+}
\ No newline at end of file
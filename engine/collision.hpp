@@ -0,0 +1,236 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// Moller-Trumbore, t is the distance along dir in units of dir's length
+bool RayTriangleIntersection( const glm::vec3& p, const glm::vec3& dir,
+	const std::array<glm::vec3, 3>& triangle, float& t );
+bool RayTriangleIntersection( const glm::vec3& p, const glm::vec3& dir,
+	const std::array<glm::vec3, 3>& triangle, glm::vec3& intersectionPoint );
+
+/*
+	Triangles split into one array per component of v0, edge1 and edge2,
+	the layout the SIMD kernels load 4 or 8 triangles at a time from.
+	The edges are precomputed, the tests only need them and the first
+	vertex. The arrays are padded with degenerate triangles so a load
+	running past the last triangle stays inside them.
+*/
+struct TriangleBatch
+{
+	static constexpr size_t Padding = 8;
+
+	std::vector<float>	v0x, v0y, v0z;
+	std::vector<float>	e1x, e1y, e1z;
+	std::vector<float>	e2x, e2y, e2z;
+	size_t				count = 0;
+
+	void build( const std::vector<std::array<glm::vec3, 3>>& triangles );
+	void clear();
+
+	size_t size() const
+	{
+		return count;
+	}
+};
+
+enum class enu_SIMD_LEVEL { scalar = 0, sse = 1, avx = 2 };
+
+// the widest kernel the cpu and the os support, checked once
+enu_SIMD_LEVEL DetectSimdLevel();
+
+// closest hit of the ray among batch[first, first + count), only hits with t <= closest count.
+// updates closest and sets index to the batch index of the hit, the result matches 
+// RayTriangleIntersection bit for bit on every level
+bool RayTrianglesIntersection( const glm::vec3& p, const glm::vec3& dir, const TriangleBatch& batch,
+	const size_t first, const size_t count, float& closest, uint32_t& index );
+bool RayTrianglesIntersection( const glm::vec3& p, const glm::vec3& dir, const TriangleBatch& batch,
+	const size_t first, const size_t count, float& closest, uint32_t& index, const enu_SIMD_LEVEL level );
+
+struct RayHit
+{
+	// along the ray, dir is expected to be normalized
+	float		distance = 0.f;
+	// index of the triangle the BVH was built from (Mesh::faces)
+	uint32_t	triangle = 0;
+	glm::vec3	point = glm::vec3( 0.f );
+};
+
+struct SweepHit
+{
+	// time of impact, the fraction of the motion covered before the contact
+	float		time = 0.f;
+	// points from the surface towards the moving shape
+	glm::vec3	normal = glm::vec3( 0.f );
+	glm::vec3	point = glm::vec3( 0.f );
+	uint32_t	triangle = 0;
+};
+
+// sphere moving by motion against a two sided triangle, the earliest contact with the face, 
+// an edge or a corner. A sphere already touching it hits at time 0 unless it moves away
+bool SweepSphereTriangle( const glm::vec3& center, const float radius, const glm::vec3& motion,
+	const std::array<glm::vec3, 3>& triangle, SweepHit& hit );
+
+// 32 bytes, two nodes share a cache line
+struct BVHNode
+{
+	glm::vec3	boundsMin;
+	// inner node: index of the second child, the first one is the next node
+	// leaf: first index into BVH::triangles
+	uint32_t	offset;
+	glm::vec3	boundsMax;
+	// number of triangles in a leaf, 0 for inner nodes
+	uint32_t	count;
+};
+
+/*
+	BVH - bounding volume hierarchy over a static triangle soup.
+
+	Built top-down with the surface area heuristic over binned triangle
+	centroids and stored depth first in a flat array, so the traversal
+	walks forward through memory and every node needs one index only.
+	Leaf triangles are copied in traversal order into a TriangleBatch, a
+	leaf is tested with one or two SIMD kernel iterations and never jumps
+	through the mesh's face indices.
+
+	Immutable once built, any number of threads can query it at once.
+*/
+class BVH
+{
+	std::vector<BVHNode>					nodes;
+	// triangles in leaf order and the index each one had in the build input
+	TriangleBatch							triangles;
+	std::vector<uint32_t>					triangleIndices;
+
+	void buildNode( const size_t nodeIndex, const size_t first, const size_t count, const size_t depth,
+		const std::vector<glm::vec3>& centroids, const std::vector<glm::vec3>& boundsMin,
+		const std::vector<glm::vec3>& boundsMax );
+
+	// calls leaf( node ) for every leaf whose box, grown by expand, the ray enters before closest
+	template <typename LeafFn> void traverse( const glm::vec3& origin, const glm::vec3& dir, const float expand,
+		float& closest, LeafFn&& leaf ) const;
+public:
+	// leaves this small are never split, larger ones only when the SAH says it pays off
+	static constexpr size_t MinLeafSize = 2;
+	static constexpr size_t MaxLeafSize = 8;
+	static constexpr size_t BinCount = 12;
+	// bounds the traversal stack
+	static constexpr size_t MaxDepth = 48;
+
+	// a few slides cover corners and creases, motion left after them is dropped
+	static constexpr int MaxSlideIterations = 4;
+	// gap kept to surfaces so the next sweep doesn't start out touching
+	static constexpr float SkinWidth = 0.01f;
+	// surfaces whose normal points up less than this are walls, about 45 degrees
+	static constexpr float WalkableNormalY = 0.7f;
+
+	void build( const std::vector<std::array<glm::vec3, 3>>& input );
+	void clear();
+
+	bool empty() const
+	{
+		return nodes.empty();
+	}
+	size_t nodeCount() const
+	{
+		return nodes.size();
+	}
+	const std::vector<BVHNode>& getNodes() const
+	{
+		return nodes;
+	}
+
+	// closest hit in ( 0, maxDistance ]
+	bool intersect( const glm::vec3& origin, const glm::vec3& dir, const float maxDistance,
+		RayHit& hit ) const;
+
+	// first contact of a sphere moving by motion, see SweepSphereTriangle
+	bool sweepSphere( const glm::vec3& center, const float radius, const glm::vec3& motion,
+		SweepHit& hit ) const;
+	// same for the capsule around the segment a-b
+	bool sweepCapsule( const glm::vec3& a, const glm::vec3& b, const float radius, const glm::vec3& motion,
+		SweepHit& hit ) const;
+
+	// moves the capsule until it touches something, then slides it along the surface with what is 
+	// left of the motion. moved is the motion that is possible, firstHit the first contact. 
+	// velocity, if given, loses its part running into every surface the slide touches. 
+	// walls up to stepHeight high are climbed instead, like the risers of stairs
+	bool slideCapsule( const glm::vec3& a, const glm::vec3& b, const float radius, const glm::vec3& motion,
+		glm::vec3& moved, SweepHit& firstHit, glm::vec3* velocity = nullptr, const float stepHeight = 0.f ) const;
+
+	// lifts the capsule by up to stepHeight, moves it by the horizontal part of motion and puts it 
+	// down on what is there. false if it is still blocked up there or lands on nothing walkable
+	bool stepCapsule( const glm::vec3& a, const glm::vec3& b, const float radius, const glm::vec3& motion,
+		const float stepHeight, glm::vec3& moved, SweepHit& ground ) const;
+};
+
+// two bodies of a SpatialHashGrid, indices in the order they were added, a < b
+struct BodyPair
+{
+	uint32_t	a;
+	uint32_t	b;
+};
+
+/*
+	SpatialHashGrid - broadphase for moving bodies.
+
+	Rebuilt from scratch every frame: the bodies' boxes are hashed into
+	the uniform cells they touch and the entries counting sorted into a
+	flat table, so a rebuild is a few linear passes without any per cell
+	allocations. Only bodies sharing a cell are compared. A pair touching
+	several cells is reported by the one cell that holds the minimum
+	corner of the two boxes' overlap, so every pair comes out once without
+	a set to dedupe them.
+
+	Bodies touching more than MaxCellsPerBody cells stay out of the table
+	and are tested against every other body instead, so one huge box can't
+	blow up the entries. Cell coordinates are clamped to +-CellLimit, far
+	away bodies share the border cells rather than overflowing the int.
+*/
+class SpatialHashGrid
+{
+	struct Body
+	{
+		glm::vec3	boundsMin;
+		glm::vec3	boundsMax;
+	};
+
+	std::vector<Body>		bodies;
+	float					cellSize = 0.f;
+
+	// bucket h holds the bodies cellBodies[cellStart[h], cellStart[h + 1]), in the order they were added
+	std::vector<uint32_t>	cellStart;
+	std::vector<uint32_t>	cellBodies;
+	// scratch space of findPairs, kept to reuse the allocations
+	std::vector<uint32_t>	entryHashes;
+	std::vector<uint32_t>	cursor;
+	std::vector<uint32_t>	oversized;
+public:
+	static constexpr int64_t MaxCellsPerBody = 64;
+	static constexpr int CellLimit = 1 << 20;
+
+	// 0 sizes the cells from the bodies, twice their average extent
+	void setCellSize( const float size )
+	{
+		cellSize = size;
+	}
+
+	void clear()
+	{
+		bodies.clear();
+	}
+	uint32_t add( const glm::vec3& boundsMin, const glm::vec3& boundsMax )
+	{
+		bodies.push_back( { boundsMin, boundsMax } );
+		return (uint32_t)bodies.size() - 1;
+	}
+	size_t size() const
+	{
+		return bodies.size();
+	}
+
+	// hashes the added bodies and appends every pair whose boxes overlap
+	void findPairs( std::vector<BodyPair>& pairs );
+};
\ No newline at end of file
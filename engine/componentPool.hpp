@@ -0,0 +1,312 @@
+#pragma once
+
+#include <new>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <type_traits>
+
+/*
+	Components are plain structs without a vtable. Whatever the storage 
+	needs to do with them (construct, copy, move, destroy) goes through 
+	this table, which registerComponent<T>() fills in once per type.
+	Trivially copyable types skip the function calls and are moved 
+	around with memcpy.
+*/
+struct ComponentTypeInfo
+{
+	size_t	size;
+	size_t	alignment;
+	// relocate/copy with memcpy, no destructor call needed
+	bool	trivial;
+
+	void	( *construct )( void* dst );
+	void	( *copy )( void* dst, const void* src );
+	void	( *moveAssign )( void* dst, void* src );
+	void	( *destroy )( void* cmp );
+
+	template <typename T> static ComponentTypeInfo create()
+	{
+		ComponentTypeInfo info;
+		info.size = sizeof( T );
+		info.alignment = alignof( T );
+		info.trivial = std::is_trivially_copyable<T>::value && std::is_trivially_destructible<T>::value;
+
+		info.construct = []( void* dst ) { new ( dst ) T(); };
+		info.copy = []( void* dst, const void* src ) { new ( dst ) T( *static_cast<const T*>( src ) ); };
+		info.moveAssign = []( void* dst, void* src ) { *static_cast<T*>( dst ) = std::move( *static_cast<T*>( src ) ); };
+		info.destroy = []( void* cmp ) { static_cast<T*>( cmp )->~T(); };
+
+		return info;
+	}
+};
+
+// allocation counters of a pool, used to check for steady-state mallocs
+struct ComponentPoolStats
+{
+	// number of blocks requested from the heap over the lifetime of the pool
+	size_t heapAllocations	= 0;
+	size_t blocksInUse		= 0;
+	size_t blocksCached		= 0;
+};
+
+/*
+	ComponentPool - sparse set storage for one component type.
+
+	The components are packed densely so systems can walk them linearly,
+	the sparse array maps a logical entity id (Vi_ID) to the position of
+	its component in the dense array.
+
+	The dense array is split into fixed size blocks. Growing only adds a 
+	block, existing components never move because of an add. Emptied 
+	blocks go to a free list and are reused before asking the heap again, 
+	so spawn/despawn churn doesn't reach the global allocator.
+
+	Removal moves the last component into the freed slot, so pointers
+	handed out by the pool are only valid until the next remove on the 
+	same pool.
+
+	Every component carries the change tick of its last write, the 
+	EntityManager stamps it so systems can skip unchanged components.
+*/
+class ComponentPool
+{
+	// power of two so the block lookup is a shift and a mask
+	static constexpr size_t ComponentsPerBlock = 256;
+
+	ComponentTypeInfo			type;
+
+	std::vector<unsigned char*>	blocks;
+	std::vector<unsigned char*>	freeBlocks;
+
+	void acquireBlock()
+	{
+		if ( freeBlocks.empty() )
+		{
+			blocks.push_back( static_cast<unsigned char*>( ::operator new( 
+				type.size * ComponentsPerBlock, std::align_val_t( type.alignment ) ) ) );
+			stats.heapAllocations++;
+		}
+		else
+		{
+			blocks.push_back( freeBlocks.back() );
+			freeBlocks.pop_back();
+		}
+
+		stats.blocksInUse = blocks.size();
+		stats.blocksCached = freeBlocks.size();
+	}
+
+	void releaseBlock()
+	{
+		freeBlocks.push_back( blocks.back() );
+		blocks.pop_back();
+
+		stats.blocksInUse = blocks.size();
+		stats.blocksCached = freeBlocks.size();
+	}
+
+	// reserves the next dense slot for vid, the caller constructs the component in it
+	void* emplace( const uint32_t vid )
+	{
+		if ( vid >= sparse.size() )
+		{
+			sparse.resize( vid + 1, npos );
+		}
+
+		const size_t index = owners.size();
+		if ( index == blocks.size() * ComponentsPerBlock )
+		{
+			acquireBlock();
+		}
+
+		sparse[vid] = (uint32_t)index;
+		owners.push_back( vid );
+		versions.push_back( 0 );
+
+		return at( index );
+	}
+public:
+	static constexpr uint32_t npos = UINT32_MAX;
+
+	// dense index -> logical id of the owner entity
+	std::vector<uint32_t>	owners;
+	// logical id -> dense index, npos if the entity has no such component
+	std::vector<uint32_t>	sparse;
+	// dense index -> change tick of the last write
+	std::vector<uint32_t>	versions;
+
+	ComponentPoolStats		stats;
+
+	const ComponentTypeInfo& typeInfo() const
+	{
+		return type;
+	}
+
+	bool has( const uint32_t vid ) const
+	{
+		return vid < sparse.size() && sparse[vid] != npos;
+	}
+
+	size_t size() const
+	{
+		return owners.size();
+	}
+
+	// sizes the sparse array for the given number of logical ids up front
+	void reserve( const size_t count )
+	{
+		if ( count > sparse.size() )
+		{
+			sparse.resize( count, npos );
+		}
+	}
+
+	// access by dense index
+	void* at( const size_t index ) const
+	{
+		return blocks[index / ComponentsPerBlock] + ( index % ComponentsPerBlock ) * type.size;
+	}
+
+	// dense index of a component handed out by the pool, npos if it isn't one of ours
+	uint32_t indexOf( const void* cmp ) const
+	{
+		const unsigned char* p = static_cast<const unsigned char*>( cmp );
+
+		for ( size_t b = 0; b < blocks.size(); b++ )
+		{
+			if ( p >= blocks[b] && p < blocks[b] + type.size * ComponentsPerBlock )
+			{
+				const size_t index = b * ComponentsPerBlock + ( p - blocks[b] ) / type.size;
+				return index < owners.size() ? (uint32_t)index : npos;
+			}
+		}
+
+		return npos;
+	}
+
+	// caller must make sure the entity owns the component
+	void* getUnchecked( const uint32_t vid ) const
+	{
+		return at( sparse[vid] );
+	}
+
+	void* get( const uint32_t vid ) const
+	{
+		return has( vid ) ? at( sparse[vid] ) : nullptr;
+	}
+
+	// default constructs the component, returns the existing one if there is any
+	void* add( const uint32_t vid )
+	{
+		if ( has( vid ) )
+		{
+			return at( sparse[vid] );
+		}
+
+		void* cmp = emplace( vid );
+		type.construct( cmp );
+
+		return cmp;
+	}
+
+	// copy of src, src must not be owned by vid 
+	void* addCopy( const uint32_t vid, const void* src )
+	{
+		if ( has( vid ) )
+		{
+			remove( vid );
+		}
+
+		void* cmp = emplace( vid );
+
+		if ( type.trivial )
+		{
+			std::memcpy( cmp, src, type.size );
+		}
+		else
+		{
+			type.copy( cmp, src );
+		}
+
+		return cmp;
+	}
+
+	void remove( const uint32_t vid )
+	{
+		if ( !has( vid ) )
+		{
+			return;
+		}
+
+		const uint32_t index = sparse[vid];
+		const uint32_t last = (uint32_t)owners.size() - 1;
+		void* lastCmp = at( last );
+
+		// fill the hole with the last element to keep the array dense
+		if ( index != last )
+		{
+			if ( type.trivial )
+			{
+				std::memcpy( at( index ), lastCmp, type.size );
+			}
+			else
+			{
+				type.moveAssign( at( index ), lastCmp );
+			}
+
+			owners[index] = owners[last];
+			versions[index] = versions[last];
+			sparse[owners[index]] = index;
+		}
+
+		if ( !type.trivial )
+		{
+			type.destroy( lastCmp );
+		}
+
+		owners.pop_back();
+		versions.pop_back();
+		sparse[vid] = npos;
+
+		if ( owners.size() <= ( blocks.size() - 1 ) * ComponentsPerBlock )
+		{
+			releaseBlock();
+		}
+	}
+
+	void clear()
+	{
+		if ( !type.trivial )
+		{
+			for ( size_t i = 0; i < owners.size(); i++ )
+			{
+				type.destroy( at( i ) );
+			}
+		}
+
+		while ( !blocks.empty() )
+		{
+			releaseBlock();
+		}
+
+		owners.clear();
+		sparse.clear();
+		versions.clear();
+	}
+
+	explicit ComponentPool( const ComponentTypeInfo& type ) : type( type ) {}
+	ComponentPool( const ComponentPool& ) = delete;
+	ComponentPool& operator=( const ComponentPool& ) = delete;
+
+	~ComponentPool()
+	{
+		clear();
+
+		for ( unsigned char* b : freeBlocks )
+		{
+			::operator delete( b, std::align_val_t( type.alignment ) );
+		}
+	}
+};
\ No newline at end of file
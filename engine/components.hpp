@@ -3,57 +3,76 @@
 #include <memory>
 #include <string>
 #include <array>
+#include <type_traits>
 #include <glm/glm.hpp>
 
-// base class for all entity manager component 
+#include "utils.hpp"
+
+/*
+	Components are plain data. They have no vtable, copying, moving and 
+	destroying them is done by the EntityManager through the function 
+	table registered with registerComponent<T>(). Keep them trivially 
+	copyable where possible so the storage can memcpy them.
+*/
+
+// base class for all entity manager component, only used as a type tag
 class Component
 {
-	// child components will override this to perform non-slicing copy
-	virtual std::unique_ptr<Component>	cloneImp() const = 0;
-public:
-	// 2 step cloning for copying the dervicd component thru base interface
-	std::unique_ptr<Component>			clone() const;
-
-	virtual								~Component();
 };
 
 class TransformComponent : public Component
 {
-	std::unique_ptr<Component> cloneImp() const;
 public:
-	glm::vec3 position;
-	glm::vec3 rotation;
-	glm::vec3 scale;
-	glm::vec3 facingDirection;
+	glm::vec3 position			= glm::vec3( 0.f, 0.f, 0.f );
+	glm::vec3 rotation			= glm::vec3( 0.f, 0.f, 0.f );
+	glm::vec3 scale				= glm::vec3( 1.f, 1.f, 1.f );
+	glm::vec3 facingDirection	= glm::vec3( 0.f, 0.f, -1.f );
 	   
 // these are frame-by-frame forces that the physics system
 // will handle and null after use 
-	glm::vec3 impulseForces;
+	glm::vec3 impulseForces		= glm::vec3( 0.f, 0.f, 0.f );
 
-	TransformComponent();
-	~TransformComponent();
+// set by the physics system when it runs in fixed steps, position is where the 
+// last step left the entity and position + renderOffset is where it is drawn
+	glm::vec3 renderOffset		= glm::vec3( 0.f, 0.f, 0.f );
+
+// written by the renderer every frame from the fields above
+	glm::mat4x4 modelMatrix		= glm::mat4x4( 1.f );
 };
 
 class MeshComponent : public Component
 {
-	std::unique_ptr<Component> cloneImp() const;
 public:
-	// meshes themselves are stored in ResourceManager 
-	std::string meshName;
-	std::string textureName;
+	// meshes themselves are stored in ResourceManager, names are 
+	// resolved to these handles when they are assigned
+	MeshHandle mesh				= UNSET_HANDLE;
+	TextureHandle texture		= UNSET_HANDLE;
+};
 
-	MeshComponent();
-	~MeshComponent();
+// tag of the entities of the active scene, kept by the SceneManager so systems 
+// can view the active scene instead of walking Scene::entities every frame
+class ActiveSceneComponent : public Component
+{
 };
 
 class RigidbodyComponent : public Component
 {
-	std::unique_ptr<Component> cloneImp() const;
 public:
-	bool collidable;
-	bool affectedByGravity;
-	glm::vec3 velocity;
+	bool collidable				= true;
+	bool affectedByGravity		= false;
+// units per second, gravity accumulates in it and contacts take out the part into the surface
+	glm::vec3 velocity			= glm::vec3( 0.f, 0.f, 0.f );
+// displacement of the last physics step, velocity and impulses after the collisions
+	glm::vec3 stepMotion		= glm::vec3( 0.f, 0.f, 0.f );
+// collision shape, a capsule from TransformComponent::position down by height, 
+// a height of 0 makes it a sphere around the position. The broadphase boxes it
+	float radius				= 0.5f;
+	float height				= 0.f;
+// highest wall the body climbs when it walks into it, like a stair riser
+	float stepHeight			= 0.f;
+};
 
-	RigidbodyComponent();
-	~RigidbodyComponent();
-};
\ No newline at end of file
+static_assert( std::is_trivially_copyable<TransformComponent>::value, "TransformComponent must stay trivially copyable." );
+static_assert( std::is_trivially_copyable<MeshComponent>::value, "MeshComponent must stay trivially copyable." );
+static_assert( std::is_trivially_copyable<ActiveSceneComponent>::value, "ActiveSceneComponent must stay trivially copyable." );
+static_assert( std::is_trivially_copyable<RigidbodyComponent>::value, "RigidbodyComponent must stay trivially copyable." );
\ No newline at end of file
@@ -2,13 +2,19 @@
 #include "vulkanBuffer.hpp"
 #include "vulkanDevice.hpp"
 #include "vulkanPipelineHelpers.hpp"
+#include <string>
 #include <algorithm>
+#include <functional>
 
 #include "playerController.hpp"
 #include "camera.hpp"
 #include "renderer.hpp"
 #include "entityManager.hpp"
 #include "components.hpp"
+#include "taskScheduler.hpp"
+#include "cvar.hpp"
+
+extern CVar ts_profile;
 
 bool DebugOverlay::checkBuffers()
 {
@@ -371,6 +377,92 @@ void DebugOverlay::draw( VkCommandBuffer commandBuffer )
 	}
 }
 
+void DebugOverlay::drawTaskSchedulerWindow()
+{
+	TaskProfiler& profiler = TaskScheduler::instance()->getProfiler();
+
+	ImGui::SetNextWindowSize( ImVec2( 520.f, 300.f ), ImGuiCond_FirstUseEver );
+	ImGui::Begin( "Task Scheduler", nullptr, ImGuiWindowFlags_NoSavedSettings );
+
+	// the application applies the cvar every frame
+	bool enabled = ts_profile.intValue == 1;
+	if ( ImGui::Checkbox( "Profile", &enabled ) )
+	{
+		ts_profile.setValue( enabled ? "1" : "0" );
+	}
+
+	ImGui::SameLine();
+	if ( ImGui::Button( "Clear" ) )
+	{
+		profiler.clear();
+	}
+
+	ImGui::SameLine();
+	if ( ImGui::Button( "Export trace" ) )
+	{
+		profiler.exportChromeTrace( "task_trace.json" );
+	}
+
+	const std::vector<TaskWorkerStats> stats = profiler.getStats();
+	for ( size_t i = 0; i < stats.size(); i++ )
+	{
+		const TaskWorkerStats& s = stats[i];
+		const double total = s.busyMs + s.idleMs;
+
+		ImGui::Text( "%s %zu: %zu tasks, %.0f%% busy, %zu wakeups, %zu/%zu steals, queue max %zu",
+			i + 1 == stats.size() ? "other " : "worker", i, s.tasksExecuted,
+			total > 0.0 ? 100.0 * s.busyMs / total : 0.0, s.wakeups, s.steals, s.stealAttempts,
+			s.queueHighWater );
+	}
+
+	// the last few milliseconds of the timeline, one row per thread
+	const std::vector<TaskTimelineEvent> timeline = profiler.getTimeline();
+	if ( !timeline.empty() )
+	{
+		const float rowHeight = 14.f;
+		const float width = std::max( ImGui::GetContentRegionAvail().x, 100.f );
+		const uint64_t windowNs = 20'000'000;
+
+		uint64_t end = 0;
+		for ( const TaskTimelineEvent& e : timeline )
+		{
+			end = std::max( end, e.end );
+		}
+		const uint64_t begin = end > windowNs ? end - windowNs : 0;
+
+		const ImVec2 origin = ImGui::GetCursorScreenPos();
+		ImDrawList* drawList = ImGui::GetWindowDrawList();
+
+		for ( const TaskTimelineEvent& e : timeline )
+		{
+			if ( e.end < begin )
+			{
+				continue;
+			}
+
+			const float x0 = origin.x + width * ( std::max( e.begin, begin ) - begin ) / (float)windowNs;
+			const float x1 = std::max( origin.x + width * ( e.end - begin ) / (float)windowNs, x0 + 1.f );
+			const float y0 = origin.y + e.thread * rowHeight;
+			const ImVec2 min( x0, y0 );
+			const ImVec2 max( x1, y0 + rowHeight - 2.f );
+
+			// same name, same color
+			const ImU32 hash = (ImU32)std::hash<std::string>()( e.name );
+			drawList->AddRectFilled( min, max, IM_COL32( 64 + hash % 192, 64 + ( hash >> 8 ) % 192, 64 + ( hash >> 16 ) % 192, 255 ) );
+
+			if ( ImGui::IsMouseHoveringRect( min, max ) )
+			{
+				ImGui::SetTooltip( "%s\n%.3f ms\nrange %zu-%zu", e.name, ( e.end - e.begin ) / 1'000'000.0,
+					e.rangeStart, e.rangeEnd );
+			}
+		}
+
+		ImGui::Dummy( ImVec2( width, rowHeight * stats.size() ) );
+	}
+
+	ImGui::End();
+}
+
 void DebugOverlay::update( VkCommandBuffer commandBuffer ) {}
 
 void DebugOverlay::init()
@@ -38,6 +38,10 @@ protected:
 	bool					checkBuffers();
 	virtual void			draw( VkCommandBuffer commandBuffer );
 
+	// window with the TaskScheduler's per worker counters and the latest task timeline, 
+	// call between ImGui::NewFrame() and ImGui::Render()
+	void					drawTaskSchedulerWindow();
+
 public:
 // dependencies 	
 	VulkanDevice*			device = nullptr;
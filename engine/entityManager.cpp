@@ -2,66 +2,320 @@
 #include "components.hpp"
 #include <algorithm>
 
+std::atomic<size_t> ComponentTypeId::counter{ 0 };
+std::atomic<size_t> ViewTypeId::counter{ 0 };
+
 std::unique_ptr<EntityManager> EntityManager::_instance = std::make_unique<EntityManager>();
 EntityManager* EntityManager::instance()
 {
 	return _instance.get();
 }
 
-void EntityManager::resizeComponentMap()
+// grows the capacity geometrically so a series of small adds doesn't reallocate each time
+template <typename T> void GrowCapacity( std::vector<T>& v, const size_t capacity )
 {
-	for ( auto &it : componentMap )
+	if ( capacity > v.capacity() )
 	{
-		it.second.resize( it.second.size() + 1 );
-		it.second.back() = nullptr;
+		v.reserve( std::max( capacity, v.capacity() * 2 ) );
 	}
 }
 
-E_ID EntityManager::addEntity()
+template <typename T> void GrowTo( std::vector<T>& v, const size_t size )
 {
-	if ( IdManager<Vi_ID>::freeIds.empty() )
+	GrowCapacity( v, size );
+
+	if ( size > v.size() )
 	{
-		resizeComponentMap();
+		v.resize( size );
 	}
+}
 
-	E_ID id = IDGET( E_ID );
-	virtualIds[id] = IDGET( Vi_ID );
+void EntityManager::assignSlot( const E_ID id, const Vi_ID vid )
+{
+	GrowTo( entitySlots, id.v + 1 );
+	GrowTo( physicalIds, vid.v + 1 );
 
-	return id;
+	entitySlots[id.v].id = id;
+	entitySlots[id.v].vid = vid;
+	physicalIds[vid.v] = id;
 }
 
-E_ID EntityManager::addEntity( const E_ID existingId )
+bool EntityManager::matches( const EntityView& view, const uint32_t vid ) const
 {
-	if ( IdManager<Vi_ID>::freeIds.empty() )
+	for ( const ComponentPool* p : view.pools )
 	{
-		resizeComponentMap();
+		if ( !p->has( vid ) )
+		{
+			return false;
+		}
 	}
 
+	return true;
+}
+
+void EntityManager::initView( EntityView& view, std::vector<size_t>&& typeIds, 
+	std::vector<ComponentPool*>&& pools )
+{
+	view.typeIds = std::move( typeIds );
+	view.pools = std::move( pools );
+	view.physicalIds = &physicalIds;
+
+	for ( const size_t typeId : view.typeIds )
+	{
+		if ( typeId >= viewsByComponent.size() )
+		{
+			viewsByComponent.resize( typeId + 1 );
+		}
+
+		viewsByComponent[typeId].push_back( &view );
+	}
+
+	// initial fill, only the smallest pool has to be walked
+	const ComponentPool* driver = view.pools[0];
+	for ( const ComponentPool* p : view.pools )
+	{
+		driver = p->size() < driver->size() ? p : driver;
+	}
+
+	for ( const uint32_t vid : driver->owners )
+	{
+		if ( matches( view, vid ) )
+		{
+			view.insert( vid );
+		}
+	}
+}
+
+void EntityManager::componentAdded( const size_t typeId, const uint32_t vid )
+{
+	if ( typeId >= viewsByComponent.size() )
+	{
+		return;
+	}
+
+	for ( EntityView* view : viewsByComponent[typeId] )
+	{
+		if ( matches( *view, vid ) )
+		{
+			view->insert( vid );
+		}
+	}
+}
+
+void EntityManager::componentRemoved( const size_t typeId, const uint32_t vid )
+{
+	if ( typeId >= viewsByComponent.size() )
+	{
+		return;
+	}
+
+	for ( EntityView* view : viewsByComponent[typeId] )
+	{
+		view->erase( vid );
+	}
+}
+
+void EntityManager::poolReplaced( const size_t typeId )
+{
+	if ( typeId >= viewsByComponent.size() )
+	{
+		return;
+	}
+
+	// the new pool is empty, so no entity can match the views using it 
+	for ( EntityView* view : viewsByComponent[typeId] )
+	{
+		for ( size_t i = 0; i < view->typeIds.size(); i++ )
+		{
+			if ( view->typeIds[i] == typeId )
+			{
+				view->pools[i] = componentPools[typeId].get();
+			}
+		}
+
+		view->clear();
+	}
+}
+
+E_ID EntityManager::addEntity()
+{
+	E_ID id = IDGET( E_ID );
+	Vi_ID vid = IDGET( Vi_ID );
+
+	assignSlot( id, vid );
+
+	return id;
+}
+
+E_ID EntityManager::addEntity( const E_ID existingId )
+{
 	Vi_ID vid = IDGET( Vi_ID );
 
-	virtualIds[existingId] = vid;
+	assignSlot( existingId, vid );
 
 	return existingId;
 };
 
-bool EntityManager::isIdValid( E_ID id ) const
+std::vector<E_ID> EntityManager::addEntities( const size_t count )
 {
-	return virtualIds.count( id ) != 0;
+	std::vector<E_ID> ids;
+	ids.reserve( count );
+
+	// new slots are only needed for what the free lists can't cover
+	const size_t newSlots = count - std::min( count, IdManager<E_ID>::freeIds.size() );
+	const size_t newVids = count - std::min( count, IdManager<Vi_ID>::freeIds.size() );
+	GrowCapacity( entitySlots, entitySlots.size() + newSlots );
+	GrowCapacity( physicalIds, physicalIds.size() + newVids );
+
+	for ( size_t i = 0; i < count; i++ )
+	{
+		ids.push_back( addEntity() );
+	}
+
+	return ids;
+}
+
+void EntityManager::removeEntities( std::span<const E_ID> ids, bool freeIds )
+{
+	std::vector<Vi_ID> vids;
+	vids.reserve( ids.size() );
+
+	for ( const E_ID& id : ids )
+	{
+		if ( !isIdValid( id ) )
+		{
+			continue;
+		}
+
+		EntitySlot& slot = entitySlots[id.v];
+		vids.push_back( slot.vid );
+
+		for ( auto& view : views )
+		{
+			if ( view )
+			{
+				view->erase( (uint32_t)slot.vid.v );
+			}
+		}
+
+		if ( freeIds )
+			IDFREE( slot.id );
+
+		slot.vid = UNSET_ID;
+	}
+
+	// pool by pool instead of entity by entity, empty pools are skipped entirely
+	for ( auto& it : componentPools )
+	{
+		if ( !it || it->size() == 0 )
+		{
+			continue;
+		}
+
+		for ( const Vi_ID& vid : vids )
+		{
+			it->remove( (uint32_t)vid.v );
+		}
+	}
+
+	for ( Vi_ID vid : vids )
+	{
+		IDFREE( vid );
+	}
+}
+
+void EntityManager::reserve( const size_t entityCount )
+{
+	entitySlots.reserve( entityCount );
+	physicalIds.reserve( entityCount );
+
+	for ( auto& it : componentPools )
+	{
+		if ( it )
+		{
+			it->reserve( entityCount );
+		}
+	}
+}
+
+size_t EntityManager::getComponentHeapAllocations() const
+{
+	size_t sum = 0;
+
+	for ( const auto& it : componentPools )
+	{
+		if ( it )
+		{
+			sum += it->stats.heapAllocations;
+		}
+	}
+
+	return sum;
+}
+
+E_ID EntityManager::cloneEntity( const E_ID source )
+{
+	if ( !isIdValid( source ) )
+	{
+		return UNSET_ID;
+	}
+
+	E_ID id = addEntity();
+	const uint32_t from = (uint32_t)entitySlots[source.v].vid.v;
+	const uint32_t to = (uint32_t)entitySlots[id.v].vid.v;
+
+	for ( auto& it : componentPools )
+	{
+		if ( it && it->has( from ) )
+		{
+			it->addCopy( to, it->getUnchecked( from ) );
+			it->versions[it->sparse[to]] = changeTick;
+		}
+	}
+
+	// the clone matches exactly the views the source is part of
+	for ( auto& view : views )
+	{
+		if ( view && view->contains( from ) )
+		{
+			view->insert( to );
+		}
+	}
+
+	return id;
 }
 
 void EntityManager::removeEntity( E_ID id, bool freeId )
 {
-	Vi_ID vid = virtualIds[id];
+	if ( !isIdValid( id ) )
+	{
+		return;
+	}
+
+	EntitySlot& slot = entitySlots[id.v];
+	Vi_ID vid = slot.vid;
 
-	for ( auto& it : componentMap )
+	for ( auto& view : views )
 	{
-		it.second[vid.v] = nullptr;
+		if ( view )
+		{
+			view->erase( (uint32_t)vid.v );
+		}
 	}
 
-	virtualIds.erase( id );
+	for ( auto& it : componentPools )
+	{
+		if ( it )
+		{
+			it->remove( (uint32_t)vid.v );
+		}
+	}
 
+	// free the stored id, the caller's copy might not carry the generation (eg.: from Lua)
 	if ( freeId )
-		IDFREE( id );
+		IDFREE( slot.id );
+
+	slot.vid = UNSET_ID;
 
 	IDFREE( vid );
 }
@@ -71,12 +325,16 @@ void EntityManager::initialize()
 	registerComponent<TransformComponent>();
 	registerComponent<MeshComponent>();
 	registerComponent<RigidbodyComponent>();
+	registerComponent<ActiveSceneComponent>();
 }
 
 void EntityManager::shutdown()
 {	
-	componentMap.clear();
-	virtualIds.clear();	
+	views.clear();
+	viewsByComponent.clear();
+	componentPools.clear();
+	entitySlots.clear();	
+	physicalIds.clear();
 	IDRESET( E_ID );
 	IDRESET( Vi_ID );
 }
\ No newline at end of file
@@ -3,72 +3,339 @@
 #include <map>
 #include <vector>
 #include <memory>
+#include <span>
+#include <atomic>
+#include <utility>
+#include <cassert>
 #include <type_traits>
 
 #include "idManager.hpp"
 #include "utils.hpp"
+#include "componentPool.hpp"
+#include "entityView.hpp"
 
 class Component;
 
+/*
+	hands out a sequential index to every component type on first use, 
+	the EntityManager uses it to find the type's pool with a single array index
+*/
+class ComponentTypeId
+{
+	static std::atomic<size_t> counter;
+public:
+	template<typename T> static size_t get()
+	{
+		static const size_t id = counter++;
+		return id;
+	}
+};
+
+// same for every distinct list of components a view is requested with
+class ViewTypeId
+{
+	static std::atomic<size_t> counter;
+public:
+	template<typename... Ts> static size_t get()
+	{
+		static const size_t id = counter++;
+		return id;
+	}
+};
+
+// entry of the E_ID -> Vi_ID slot map
+struct EntitySlot
+{
+	// the id with the generation it was handed out with, stale handles won't match it
+	E_ID	id;
+	// UNSET_ID if the slot is free
+	Vi_ID	vid;
+};
+
 class EntityManager
 {
-	// stores every component 
-	using ComponentMap_t = std::map <const type_info*, std::vector<std::unique_ptr<Component>>>;
-	// maps entity ids to component map ids, saves space at the cost of lookup perf.
-	using VirtualizationMap_t = std::map<E_ID, Vi_ID>;
+	// stores every component, one densely packed pool per type indexed by ComponentTypeId
+	using ComponentPools_t = std::vector<std::unique_ptr<ComponentPool>>;
+	// maps entity ids to component pool ids, indexed directly by E_ID::v 
+	using SlotMap_t = std::vector<EntitySlot>;
 	
-	ComponentMap_t		componentMap;
-	VirtualizationMap_t	virtualIds;
+	ComponentPools_t	componentPools;
+	SlotMap_t			entitySlots;
+	// reverse of entitySlots, indexed by Vi_ID::v so iteration can report the owner
+	std::vector<E_ID>	physicalIds;
+
+	// cached queries indexed by ViewTypeId
+	std::vector<std::unique_ptr<EntityView>>	views;
+	// views to update when a component of the type is added or removed, indexed by ComponentTypeId
+	std::vector<std::vector<EntityView*>>		viewsByComponent;
+
+	// stamped on every component written during the current frame
+	uint32_t			changeTick = 1;
 
 	static std::unique_ptr<EntityManager> _instance;
 
-	void resizeComponentMap();
+	void assignSlot( const E_ID id, const Vi_ID vid );
+
+	// view maintenance
+	bool matches( const EntityView& view, const uint32_t vid ) const;
+	void initView( EntityView& view, std::vector<size_t>&& typeIds, std::vector<ComponentPool*>&& pools );
+	void componentAdded( const size_t typeId, const uint32_t vid );
+	void componentRemoved( const size_t typeId, const uint32_t vid );
+	void poolReplaced( const size_t typeId );
+
+	template<typename T> ComponentPool* pool()
+	{
+		const size_t typeId = ComponentTypeId::get<T>();
+		assert( typeId < componentPools.size() && componentPools[typeId] && "EntityManager: component type is not registered." );
+
+		return componentPools[typeId].get();
+	}
+
+	// pools[0] holds T, pools[I + 1] the I-th of Ts
+	template<typename T, typename... Ts, typename Fn, size_t... I> static void invoke( Fn& fn, E_ID id, 
+		ComponentPool* const* pools, const uint32_t vid, std::index_sequence<I...> )
+	{
+		fn( id, *static_cast<T*>( pools[0]->getUnchecked( vid ) ),
+			*static_cast<Ts*>( pools[I + 1]->getUnchecked( vid ) )... );
+	}
 public:
 	// add component 
 	template<typename T> T*	add( E_ID id )
 	{
-		T* cmp = (T*)componentMap[&typeid( T )][virtualIds[id].v].get();
-
-		if ( cmp )
-			return cmp;
-
-		componentMap[&typeid( T )][virtualIds[id].v] = std::make_unique<T>();
-
-		return (T*)componentMap[&typeid( T )][virtualIds[id].v].get();
+		return isIdValid( id ) ? add<T>( entitySlots[id.v].vid ) : nullptr;
 	}
 	template<typename T> T* add( Vi_ID vid )
 	{
-		T* cmp = (T*)componentMap[&typeid( T )][vid.v].get();
+		ComponentPool* p = pool<T>();
+		const uint32_t v = (uint32_t)vid.v;
+
+		if ( p->has( v ) )
+		{
+			p->versions[p->sparse[v]] = changeTick;
+			return static_cast<T*>( p->getUnchecked( v ) );
+		}
 
-		if ( cmp )
-			return cmp;
+		T* cmp = static_cast<T*>( p->add( v ) );
+		p->versions[p->sparse[v]] = changeTick;
+		componentAdded( ComponentTypeId::get<T>(), v );
 
-		componentMap[&typeid( T )][vid.v] = std::make_unique<T>();
+		return cmp;
+	}
+
+	// remove component
+	template<typename T> void remove( E_ID id )
+	{
+		if ( !isIdValid( id ) )
+		{
+			return;
+		}
 
-		return (T*)componentMap[&typeid( T )][vid.v].get();
+		const uint32_t vid = (uint32_t)entitySlots[id.v].vid.v;
+		if ( pool<T>()->has( vid ) )
+		{
+			componentRemoved( ComponentTypeId::get<T>(), vid );
+			pool<T>()->remove( vid );
+		}
 	}
 
-	// get component 
+	// get component for writing, counts as a change of the component
 	template<typename T> T* get( Vi_ID vid )
 	{
-		return (T*)componentMap.at( &typeid( T ) ).at( vid.v ).get();
+		ComponentPool* p = pool<T>();
+		const uint32_t v = (uint32_t)vid.v;
+
+		if ( !p->has( v ) )
+		{
+			return nullptr;
+		}
+
+		p->versions[p->sparse[v]] = changeTick;
+		return static_cast<T*>( p->getUnchecked( v ) );
 	}
 	template<typename T> T*	get( E_ID id )
 	{
-		return isIdValid( id ) ? get<T>( virtualIds.at( id ) ) : nullptr;
+		return isIdValid( id ) ? get<T>( entitySlots[id.v].vid ) : nullptr;
+	}
+
+	// get component for reading, leaves the change tick alone
+	template<typename T> const T* getConst( E_ID id )
+	{
+		return isIdValid( id ) ? static_cast<const T*>( pool<T>()->get( (uint32_t)entitySlots[id.v].vid.v ) ) : nullptr;
+	}
+
+	/*
+		change tracking: add() and get() stamp the component with the current 
+		tick. Views hand out plain references, systems writing through them 
+		call markChanged() themselves. Ticks are advanced once per frame.
+	*/
+	template<typename T> void markChanged( E_ID id )
+	{
+		if ( !isIdValid( id ) )
+		{
+			return;
+		}
+
+		ComponentPool* p = pool<T>();
+		const uint32_t vid = (uint32_t)entitySlots[id.v].vid.v;
+		if ( p->has( vid ) )
+		{
+			p->versions[p->sparse[vid]] = changeTick;
+		}
+	}
+	// for callers that only hold the component (eg.: Lua setters)
+	template<typename T> void markChanged( const T* cmp )
+	{
+		ComponentPool* p = pool<T>();
+		const uint32_t index = p->indexOf( cmp );
+		if ( index != ComponentPool::npos )
+		{
+			p->versions[index] = changeTick;
+		}
+	}
+
+	// true if the component was written during or after the given tick
+	template<typename T> bool changedSince( E_ID id, const uint32_t tick )
+	{
+		if ( !isIdValid( id ) )
+		{
+			return false;
+		}
+
+		const ComponentPool* p = pool<T>();
+		const uint32_t vid = (uint32_t)entitySlots[id.v].vid.v;
+		return p->has( vid ) && p->versions[p->sparse[vid]] >= tick;
+	}
+
+	// calls fn( E_ID, T& ) for every component written during or after the given tick
+	template<typename T, typename Fn> void eachChanged( const uint32_t tick, Fn&& fn )
+	{
+		ComponentPool* p = pool<T>();
+
+		for ( size_t i = 0; i < p->size(); i++ )
+		{
+			if ( p->versions[i] >= tick )
+			{
+				fn( physicalIds[p->owners[i]], *static_cast<T*>( p->at( i ) ) );
+			}
+		}
+	}
+
+	uint32_t getChangeTick() const
+	{
+		return changeTick;
+	}
+	// called once per frame, returns the new tick
+	uint32_t advanceChangeTick()
+	{
+		return ++changeTick;
+	}
+
+	/*
+		calls fn( E_ID, T&, Ts&... ) for every entity that has all the listed 
+		components. The smallest pool drives the iteration so the rarest 
+		component decides the cost. Adding or removing components of the 
+		iterated types inside fn is not allowed.
+	*/
+	template<typename T, typename... Ts, typename Fn> void each( Fn&& fn )
+	{
+		ComponentPool* pools[] = { pool<T>(), pool<Ts>()... };
+
+		const ComponentPool* driver = pools[0];
+		for ( const ComponentPool* p : pools )
+		{
+			driver = p->size() < driver->size() ? p : driver;
+		}
+
+		for ( size_t i = 0; i < driver->owners.size(); i++ )
+		{
+			const uint32_t vid = driver->owners[i];
+
+			bool match = true;
+			for ( const ComponentPool* p : pools )
+			{
+				match = match && p->has( vid );
+			}
+
+			if ( match )
+			{
+				invoke<T, Ts...>( fn, physicalIds[vid], pools, vid, std::index_sequence_for<Ts...>() );
+			}
+		}
+	}
+
+	/*
+		cached version of each(): the matching entities are tracked as 
+		components come and go, iterating costs O(matches). The view is 
+		created on the first call and stays valid until shutdown().
+	*/
+	template<typename... Ts> View<Ts...>& view()
+	{
+		static_assert( sizeof...( Ts ) > 0, "EntityManager::view: at least one component type is needed." );
+
+		const size_t viewId = ViewTypeId::get<Ts...>();
+		if ( viewId >= views.size() )
+		{
+			views.resize( viewId + 1 );
+		}
+
+		if ( !views[viewId] )
+		{
+			std::unique_ptr<View<Ts...>> v = std::make_unique<View<Ts...>>();
+			initView( *v, { ComponentTypeId::get<Ts>()... }, { pool<Ts>()... } );
+			views[viewId] = std::move( v );
+		}
+
+		return static_cast<View<Ts...>&>( *views[viewId] );
 	}
 
 	E_ID addEntity();
 	E_ID addEntity( const E_ID existingId );
 
+	// new entity with a copy of every component of source 
+	E_ID cloneEntity( const E_ID source );
+
+	// batch versions for level loads and mass spawns, storage grows once per batch
+	std::vector<E_ID> addEntities( const size_t count );
+	void removeEntities( std::span<const E_ID> ids, bool freeIds = true );
+
+	// hint for the expected number of live entities, avoids regrowing mid-game
+	void reserve( const size_t entityCount );
+
+	// allocation counters of the component storage
+	template <typename T> const ComponentPoolStats& getPoolStats()
+	{
+		return pool<T>()->stats;
+	}
+	// number of component blocks requested from the heap by every pool
+	size_t getComponentHeapAllocations() const;
+
 	template <typename T> void registerComponent()
 	{
 		static_assert( std::is_base_of<Component, T>::value, "EntityManager::registerComponent: type must be a derived class of Component." );
-		componentMap[&typeid( T )] = std::vector<std::unique_ptr<Component>>();
-		componentMap[&typeid( T )].resize( virtualIds.size() );
+
+		const size_t typeId = ComponentTypeId::get<T>();
+		if ( typeId >= componentPools.size() )
+		{
+			componentPools.resize( typeId + 1 );
+		}
+
+		componentPools[typeId] = std::make_unique<ComponentPool>( ComponentTypeInfo::create<T>() );
+		poolReplaced( typeId );
+	}
+
+	// O(1), rejects ids of removed entities and ids from an older generation
+	bool isIdValid( E_ID id ) const
+	{
+		return id.v >= 0 && (size_t)id.v < entitySlots.size() 
+			&& entitySlots[id.v].vid != UNSET_ID && entitySlots[id.v].id == id;
 	}
 
-	bool isIdValid( E_ID id ) const;
+	// the id with the generation of the entity living in the slot, ids built from a 
+	// bare number match any generation. UNSET_ID when the id is not valid
+	E_ID resolveId( E_ID id ) const
+	{
+		return isIdValid( id ) ? entitySlots[id.v].id : E_ID( UNSET_ID );
+	}
 
 	void removeEntity( E_ID id, bool freeId = true );
 
@@ -76,4 +343,4 @@ public:
 	void shutdown();
 
 	static EntityManager* instance();
-};
+};
\ No newline at end of file
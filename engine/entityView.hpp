@@ -0,0 +1,116 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <utility>
+
+#include "idManager.hpp"
+#include "componentPool.hpp"
+
+/*
+	EntityView - cached result of a component query.
+
+	Holds the logical ids of every entity that owns all the components
+	of the query. The EntityManager updates the set whenever one of
+	those components is added or removed, so walking a view costs
+	O(matches) instead of a lookup per component for every entity.
+
+	Views are created by EntityManager::view<Ts...>() and owned by it.
+*/
+class EntityView
+{
+	friend class EntityManager;
+
+	static constexpr uint32_t npos = UINT32_MAX;
+
+	// logical id -> index in members, npos if the entity isn't part of the view
+	std::vector<uint32_t>		sparse;
+
+	void insert( const uint32_t vid )
+	{
+		if ( vid >= sparse.size() )
+		{
+			sparse.resize( vid + 1, npos );
+		}
+
+		if ( sparse[vid] != npos )
+		{
+			return;
+		}
+
+		sparse[vid] = (uint32_t)members.size();
+		members.push_back( vid );
+	}
+
+	void erase( const uint32_t vid )
+	{
+		if ( !contains( vid ) )
+		{
+			return;
+		}
+
+		const uint32_t index = sparse[vid];
+		members[index] = members.back();
+		sparse[members[index]] = index;
+
+		members.pop_back();
+		sparse[vid] = npos;
+	}
+
+	void clear()
+	{
+		members.clear();
+		sparse.clear();
+	}
+protected:
+	// component type ids of the query and their pools, in template argument order
+	std::vector<size_t>			typeIds;
+	std::vector<ComponentPool*>	pools;
+	// logical ids of the matching entities, packed
+	std::vector<uint32_t>		members;
+	// Vi_ID -> E_ID table of the EntityManager
+	const std::vector<E_ID>*	physicalIds = nullptr;
+public:
+	bool contains( const uint32_t vid ) const
+	{
+		return vid < sparse.size() && sparse[vid] != npos;
+	}
+
+	size_t size() const
+	{
+		return members.size();
+	}
+
+	bool empty() const
+	{
+		return members.empty();
+	}
+
+	virtual ~EntityView() = default;
+};
+
+template <typename... Ts> class View : public EntityView
+{
+	template<typename Fn, size_t... I> void invoke( Fn& fn, const uint32_t vid, std::index_sequence<I...> ) const
+	{
+		fn( ( *physicalIds )[vid], *static_cast<Ts*>( pools[I]->getUnchecked( vid ) )... );
+	}
+public:
+	/*
+		calls fn( E_ID, Ts&... ) for every entity of the view. Adding or
+		removing components of the viewed types inside fn is not allowed.
+	*/
+	template<typename Fn> void each( Fn&& fn ) const
+	{
+		each( fn, 0, members.size() );
+	}
+
+	// same as above for the entities [begin, end) of the view, used to split it between threads
+	template<typename Fn> void each( Fn&& fn, const size_t begin, const size_t end ) const
+	{
+		for ( size_t i = begin; i < end; i++ )
+		{
+			invoke( fn, members[i], std::index_sequence_for<Ts...>() );
+		}
+	}
+};
\ No newline at end of file
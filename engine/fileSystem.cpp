@@ -97,6 +97,29 @@ ImageInfo FileSystem::LoadImage( const std::string& filepath )
 	ii.bytes.resize( width * height * forceBPP );
 	std::memcpy( ii.bytes.data(), data, width * height * forceBPP );
 
+	stbi_image_free( data );
+	return ii;
+}
+
+ImageInfo FileSystem::LoadImage( const std::vector<char>& file )
+{
+	static int forceBPP = 4;
+
+	ImageInfo ii = {};
+
+	int width, height, bpp;
+	uint8_t* data = stbi_load_from_memory( (const stbi_uc*)file.data(), (int)file.size(), 
+		&width, &height, &bpp, STBI_rgb_alpha );
+	if ( data == nullptr )
+	{
+		return ii;
+	}
+
+	ii.width = width;
+	ii.height = height;
+	ii.bytes.resize( width * height * forceBPP );
+	std::memcpy( ii.bytes.data(), data, width * height * forceBPP );
+
 	stbi_image_free( data );
 	return ii;
 }
\ No newline at end of file
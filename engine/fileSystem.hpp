@@ -26,4 +26,6 @@ public:
 	static std::vector<char> ReadBinaryFile( const std::string& file );
 
 	static ImageInfo LoadImage( const std::string& filepath );
+	// decodes an image already read into memory, bytes is empty if it isn't an image
+	static ImageInfo LoadImage( const std::vector<char>& file );
 };
\ No newline at end of file
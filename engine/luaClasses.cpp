@@ -4,6 +4,7 @@
 #include "playerController.hpp"
 #include "entityManager.hpp"
 #include "components.hpp"
+#include "resourceManager.hpp"
 
 // IDs
 template <typename IDType>
@@ -118,33 +119,178 @@ void LComponent( sol::state& l )
 	l.new_usertype<Component>( "Component" );
 }
 
+// splits a pointer to member into the component it belongs to and the member's type
+template<typename> struct MemberTraits;
+template<typename T, typename M> struct MemberTraits<M T::*>
+{
+	using Component = T;
+	using Type = M;
+};
+
+// property of a LuaComponent proxy, the member is copied in and out so every write goes 
+// through the setter and stamps the change tick. A component that is gone reads as a 
+// default constructed one and ignores writes
+template<auto Member>
+auto ComponentProperty()
+{
+	using T = typename MemberTraits<decltype( Member )>::Component;
+	using M = typename MemberTraits<decltype( Member )>::Type;
+
+	return sol::property(
+		[]( const LuaComponent<T>& c ) -> M
+		{
+			const T* cmp = c.read();
+			return cmp ? cmp->*Member : T().*Member;
+		},
+		[]( LuaComponent<T>& c, const M& value )
+		{
+			T* cmp = c.write();
+			if ( cmp )
+			{
+				cmp->*Member = value;
+			}
+		} );
+}
+
+/*
+	LuaComponentVector - what the vec3 members of a LuaComponent proxy hand to scripts.
+
+	It is a vec3, so it goes wherever scripts pass a vec3. Setting x, y or z also 
+	writes the member of the component, so tc.position.x = 5 moves the entity and 
+	stamps the change tick like assigning the whole vector does.
+*/
+template<typename T>
+struct LuaComponentVector : public glm::vec3
+{
+	LuaComponent<T>		component;
+	glm::vec3 T::*		member = nullptr;
+};
+
+template<typename T, int Axis>
+auto ComponentVectorAxis()
+{
+	return sol::property(
+		[]( const LuaComponentVector<T>& v ) -> float
+		{
+			const T* cmp = v.component.read();
+			return cmp ? ( cmp->*v.member )[Axis] : v[Axis];
+		},
+		[]( LuaComponentVector<T>& v, const float value )
+		{
+			v[Axis] = value;
+
+			T* cmp = v.component.write();
+			if ( cmp )
+			{
+				( cmp->*v.member )[Axis] = value;
+			}
+		} );
+}
+
+template<typename T>
+void LComponentVector( sol::state& l, const std::string& name )
+{
+	l.new_usertype<LuaComponentVector<T>>( name,
+		"x", ComponentVectorAxis<T, 0>(),
+		"y", ComponentVectorAxis<T, 1>(),
+		"z", ComponentVectorAxis<T, 2>(),
+
+		// metamethods are not inherited from vec3, the results are plain vectors
+		sol::meta_function::addition, []( const glm::vec3& lhs, const glm::vec3& rhs ) -> glm::vec3
+		{
+			return lhs + rhs;
+		},
+		sol::meta_function::subtraction, []( const glm::vec3& lhs, const glm::vec3& rhs ) -> glm::vec3
+		{
+			return lhs - rhs;
+		},
+		sol::meta_function::multiplication, []( const glm::vec3& lhs, float rhs ) -> glm::vec3
+		{
+			return lhs * rhs;
+		},
+
+		sol::base_classes, sol::bases<glm::vec3>() );
+}
+
+// vec3 member of a LuaComponent proxy, reads hand out a LuaComponentVector that writes through
+template<glm::vec3 TransformComponent::* Member>
+auto TransformVectorProperty()
+{
+	using T = TransformComponent;
+
+	return sol::property(
+		[]( const LuaComponent<T>& c ) -> LuaComponentVector<T>
+		{
+			const T* cmp = c.read();
+
+			LuaComponentVector<T> v;
+			static_cast<glm::vec3&>( v ) = cmp ? cmp->*Member : T().*Member;
+			v.component = c;
+			v.member = Member;
+			return v;
+		},
+		[]( LuaComponent<T>& c, const glm::vec3& value )
+		{
+			T* cmp = c.write();
+			if ( cmp )
+			{
+				cmp->*Member = value;
+			}
+		} );
+}
+
 void LTransformComponent( sol::state& l )
 {
-	l.new_usertype<TransformComponent>( "TransformComponent",
-		"position", &TransformComponent::position,
-		"rotation", &TransformComponent::rotation,
-		"scale", &TransformComponent::scale,
-		
-		sol::base_classes, sol::bases<Component>() );
+	LComponentVector<TransformComponent>( l, "TransformVector" );
+
+	l.new_usertype<LuaComponent<TransformComponent>>( "TransformComponent",
+		"position", TransformVectorProperty<&TransformComponent::position>(),
+		"rotation", TransformVectorProperty<&TransformComponent::rotation>(),
+		"scale", TransformVectorProperty<&TransformComponent::scale>() );
 }
 
 void LMeshComponent( sol::state& l )
 {
-	l.new_usertype<MeshComponent>( "MeshComponent",
-		"meshName", &MeshComponent::meshName,
-		"textureName", &MeshComponent::textureName,
-		
-		sol::base_classes, sol::bases<Component>() );
+	l.new_usertype<LuaComponent<MeshComponent>>( "MeshComponent",
+		// scripts keep working with names, the component only stores handles
+		"meshName", sol::property(
+			[]( const LuaComponent<MeshComponent>& c ) -> std::string
+			{
+				const MeshComponent* mc = c.read();
+				return mc ? ResourceManager::instance()->getMeshName( mc->mesh ) : std::string();
+			},
+			[]( LuaComponent<MeshComponent>& c, const std::string& name )
+			{
+				MeshComponent* mc = c.write();
+				if ( mc )
+				{
+					mc->mesh = ResourceManager::instance()->getMeshHandle( name );
+				}
+			} ),
+		"textureName", sol::property(
+			[]( const LuaComponent<MeshComponent>& c ) -> std::string
+			{
+				const MeshComponent* mc = c.read();
+				return mc ? ResourceManager::instance()->getTextureName( mc->texture ) : std::string();
+			},
+			[]( LuaComponent<MeshComponent>& c, const std::string& name )
+			{
+				MeshComponent* mc = c.write();
+				if ( mc )
+				{
+					mc->texture = ResourceManager::instance()->getTextureHandle( name );
+				}
+			} ) );
 }
 
 void LRigidbodyComponent( sol::state& l )
 {
-	l.new_usertype<RigidbodyComponent>( "RigidbodyComponent",	
-		"collidable", &RigidbodyComponent::collidable,
-		"affectedByGravity", &RigidbodyComponent::affectedByGravity,
-
-		sol::base_classes, sol::bases<Component>()
-		);
+	l.new_usertype<LuaComponent<RigidbodyComponent>>( "RigidbodyComponent",	
+		"collidable", ComponentProperty<&RigidbodyComponent::collidable>(),
+		"affectedByGravity", ComponentProperty<&RigidbodyComponent::affectedByGravity>(),
+		"radius", ComponentProperty<&RigidbodyComponent::radius>(),
+		"height", ComponentProperty<&RigidbodyComponent::height>(),
+		"stepHeight", ComponentProperty<&RigidbodyComponent::stepHeight>() );
 }
 
 void LuaStateController::registerClasses()
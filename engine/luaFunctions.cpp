@@ -11,19 +11,29 @@
 #include "resourceManager.hpp"
 #include "playerController.hpp"
 #include "application.hpp"
+#include "taskCoroutine.hpp"
 
 extern CVar window_title;
 
+// scripts get proxies that resolve the component on every access, see LuaComponent
 #define COMPONENT_PROPERTIES( ComponentName )							\
-ComponentName* Add##ComponentName ( sol::object obj )					\
+sol::optional<LuaComponent<ComponentName>> Add##ComponentName ( sol::object obj )	\
 {																		\
 	E_ID id = solObjectToId<E_ID>( obj );								\
-	return EntityManager::instance()->add<ComponentName>( id );			\
+	if ( EntityManager::instance()->add<ComponentName>( id ) == nullptr )	\
+	{																	\
+		return sol::nullopt;											\
+	}																	\
+	return LuaComponent<ComponentName>{ id };							\
 }																		\
-ComponentName* Get##ComponentName ( sol::object obj )					\
+sol::optional<LuaComponent<ComponentName>> Get##ComponentName ( sol::object obj )	\
 {																		\
 	E_ID id = solObjectToId<E_ID>( obj );								\
-	return EntityManager::instance()->get<ComponentName>( id );			\
+	if ( EntityManager::instance()->getConst<ComponentName>( id ) == nullptr )	\
+	{																	\
+		return sol::nullopt;											\
+	}																	\
+	return LuaComponent<ComponentName>{ id };							\
 }																		
 
 #define COMPONENT_REGISTERS( ComponentName )				\
@@ -35,43 +45,70 @@ void DebugPrint( sol::object obj )
 {
 	Logger::PrintToOutputWindow( obj.as<std::string>() );
 }
-void LoadAllTextures()
+Task<void> StreamTexture( const std::string name )
 {
-	std::vector<std::string> textures = FileSystem::GetFilesInDirectory( "textures", "png" );
-	
-	for ( const auto& t : textures )
+	const std::string path = "textures\\" + name + ".png";
+
+	// read and decode on the background workers
+	std::vector<char> file = co_await readFile( path );
+	ImageInfo image = FileSystem::LoadImage( file );
+
+	// the resource tables and the upload belong to the main thread
+	co_await nextFrame();
+
+	if ( image.bytes.empty() )
 	{
-		char buffer[256];
-		std::snprintf( buffer, 256, "textures\\%s.png", t.c_str() );
-		
-		if ( ResourceManager::instance()->loadImage( buffer, t ) )
-		{
-			Renderer::instance()->loadTexture( t );
-		}
-		else
-		{
-			Logger::WriteToErrorLog( "ResourceManager::loadImage failed to load image: %s", t.c_str() );
-		}
+		Logger::WriteToErrorLog( "ResourceManager::loadImage failed to load image: %s", name.c_str() );
+		co_return;
 	}
+
+	ResourceManager::instance()->addImage( name, path, std::move( image ) );
+	Renderer::instance()->loadTexture( name );
 }
-void LoadAllModels()
+Task<void> StreamModel( const std::string name )
 {
-	std::vector<std::string> models = FileSystem::GetFilesInDirectory( "models", "obj" );
-	
-	for ( const auto& mdl : models )
+	co_await resumeOnWorkers( enu_TASK_PRIORITY::background );
+	std::unique_ptr<Mesh> mesh = ResourceManager::readMesh( "models\\" + name + ".obj", "models" );
+
+	co_await nextFrame();
+
+	if ( !mesh )
 	{
-		char buffer[256];
-		std::snprintf( buffer, 256, "models\\%s.obj", mdl.c_str() );
+		Logger::WriteToErrorLog( "ResourceManager::loadMesh failed to load obj file: %s", name.c_str() );
+		co_return;
+	}
 
-		if ( ResourceManager::instance()->loadMesh( buffer, mdl, "models" ) )
-		{
-			Renderer::instance()->loadModel( mdl );
-		}
-		else
-		{
-			Logger::WriteToErrorLog( "ResourceManager::loadMesh failed to load obj file: %s", mdl.c_str() );
-		}
+	ResourceManager::instance()->addMesh( name, std::move( mesh ) );
+	Renderer::instance()->loadModel( name );
+}
+// every file is loaded at the same time
+Task<void> StreamAll( const std::string directory, const std::string extension, 
+	Task<void> ( *stream )( const std::string ) )
+{
+	std::vector<TaskFuture<void>> loads;
+	for ( const auto& name : FileSystem::GetFilesInDirectory( directory, extension ) )
+	{
+		loads.push_back( spawn( stream( name ) ) );
 	}
+
+	co_await whenAll( loads );
+}
+void LoadAllTextures()
+{
+	syncWait( StreamAll( "textures", "png", StreamTexture ) );
+}
+void LoadAllModels()
+{
+	syncWait( StreamAll( "models", "obj", StreamModel ) );
+}
+// these return right away, the resources show up over the next frames
+void LoadAllTexturesAsync()
+{
+	spawn( StreamAll( "textures", "png", StreamTexture ) );
+}
+void LoadAllModelsAsync()
+{
+	spawn( StreamAll( "models", "obj", StreamModel ) );
 }
 
 // utils
@@ -91,6 +128,14 @@ float GetLastFrameTime()
 {
 	return Application::instance()->getLastFrameTime();
 }
+size_t GetComponentAllocations()
+{
+	return EntityManager::instance()->getComponentHeapAllocations();
+}
+bool ExportTaskTrace( const std::string& path )
+{
+	return TaskScheduler::instance()->getProfiler().exportChromeTrace( path );
+}
 
 // gameplay logic 
 void SetActiveScene( const std::string& name )
@@ -114,9 +159,9 @@ void SetActiveScene( const std::string& name )
 			E_ID wId = EntityManager::instance()->addEntity();
 			TransformComponent* tc = em->add<TransformComponent>( wId );
 			MeshComponent* mc = em->add<MeshComponent>( wId );
-			mc->meshName = newScene->worldObjName;
+			mc->mesh = ResourceManager::instance()->getMeshHandle( newScene->worldObjName );
 			newScene->world = wId;
-			newScene->entities.push_back( wId );
+			SceneManager::instance()->addEntityToScene( newScene->id, wId );
 		}
 		
 		SceneManager::instance()->setActiveScene( newScene->id );
@@ -129,7 +174,15 @@ void SetActiveScene( const std::string& name )
 void AddEntityToScene( sol::object eid, const std::string& name )
 {
 	E_ID id = solObjectToId<E_ID>( eid );
-	SceneManager::instance()->getScene( name )->entities.push_back( id );
+	Scene* scene = SceneManager::instance()->getScene( name );
+	if ( scene )
+	{
+		SceneManager::instance()->addEntityToScene( scene->id, id );
+	}
+	else
+	{
+		Logger::WriteToErrorLog( "Failed to add entity to scene: %s", name.c_str() );
+	}
 }
 
 // objects 
@@ -147,6 +200,10 @@ E_ID CreateEntity()
 {
 	return EntityManager::instance()->addEntity();
 }
+sol::as_table_t<std::vector<E_ID>> CreateEntities( int count )
+{
+	return sol::as_table( EntityManager::instance()->addEntities( count > 0 ? count : 0 ) );
+}
 
 
 
@@ -160,10 +217,14 @@ void LuaStateController::registerFunctions()
 	state["DebugPrint"] = DebugPrint;
 	state["LoadAllModels"] = LoadAllModels;
 	state["LoadAllTextures"] = LoadAllTextures;
+	state["LoadAllModelsAsync"] = LoadAllModelsAsync;
+	state["LoadAllTexturesAsync"] = LoadAllTexturesAsync;
 
 	state["SetWindowName"] = SetWindowTitle;
 	state["SetCVar"] = SetCVar;
 	state["GetLastFrameTime"] = GetLastFrameTime;
+	state["GetComponentAllocations"] = GetComponentAllocations;
+	state["ExportTaskTrace"] = ExportTaskTrace;
 
 	state["SetActiveScene"] = SetActiveScene;
 	state["AddEntityToScene"] = AddEntityToScene;
@@ -172,6 +233,7 @@ void LuaStateController::registerFunctions()
 	state["GetPlayerController"] = GetPlayerController;
 
 	state["CreateEntity"] = CreateEntity;
+	state["CreateEntities"] = CreateEntities;
 
 // this is ducttape
 	COMPONENT_REGISTERS( TransformComponent );
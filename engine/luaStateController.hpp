@@ -3,6 +3,7 @@
 #include <memory>
 #include <string>
 #include "libs/sol.hpp"
+#include "entityManager.hpp"
 
 template<typename T>
 T solObjectToId( const sol::object& obj )
@@ -21,6 +22,31 @@ T solObjectToId( const sol::object& obj )
 	return result;
 }
 
+/*
+	LuaComponent - what Add*Component and Get*Component hand to scripts.
+
+	Pools swap the last component into the hole a removed one leaves, so a 
+	pointer a script keeps around could end up on another entity's component. 
+	The proxy only holds the entity id and looks the component up on every 
+	access, both return nullptr once the entity or the component is gone.
+*/
+template<typename T>
+struct LuaComponent
+{
+	E_ID id;
+
+	// leaves the change tick alone
+	const T* read() const
+	{
+		return EntityManager::instance()->getConst<T>( id );
+	}
+	// counts as a change of the component
+	T* write() const
+	{
+		return EntityManager::instance()->get<T>( id );
+	}
+};
+
 class LuaStateController
 {
 	static std::unique_ptr<LuaStateController> _instance;
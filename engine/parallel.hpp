@@ -0,0 +1,51 @@
+#pragma once
+
+#include <type_traits>
+
+#include "taskScheduler.hpp"
+#include "entityView.hpp"
+
+// runs View::each over a subrange of the view, one partition per execute call
+template <typename Fn, typename... Ts> class ViewTask : public RangedTask
+{
+	const View<Ts...>&	view;
+	Fn&					fn;
+public:
+	ViewTask( const View<Ts...>& view, Fn& fn ) : view( view ), fn( fn )
+	{
+		rangeSize = view.size();
+		name = "parallelForEach";
+	}
+
+	void execute( const TaskRange& range ) override
+	{
+		view.each( fn, range.start, range.end );
+	}
+};
+
+// below this many entities splitting the view costs more than it saves
+constexpr size_t ParallelForEachMinEntities = 256;
+
+/*
+	calls fn( E_ID, Ts&... ) for every entity of the view, spread over the
+	TaskScheduler's worker threads, and returns when every entity is done.
+
+	fn runs concurrently on different entities, it must only write the
+	components it is handed. Small views and an uninitialized scheduler
+	fall back to a plain View::each on the calling thread.
+*/
+template <typename... Ts, typename Fn> void parallelForEach( const View<Ts...>& view, Fn&& fn )
+{
+	TaskScheduler* ts = TaskScheduler::instance();
+
+	if ( ts->getThreadCount() == 0 || view.size() < ParallelForEachMinEntities )
+	{
+		view.each( fn );
+		return;
+	}
+
+	ViewTask<std::remove_reference_t<Fn>, Ts...> task( view, fn );
+
+	ts->execute( &task );
+	ts->waitFor( &task );
+}
\ No newline at end of file
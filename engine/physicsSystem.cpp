@@ -4,6 +4,10 @@
 #include "components.hpp"
 #include "resourceManager.hpp"
 #include "scene.hpp"
+#include "parallel.hpp"
+#include "cvar.hpp"
+#include <cmath>
+#include <algorithm>
 
 std::unique_ptr<PhysicsSystem> PhysicsSystem::_instance = std::make_unique<PhysicsSystem>();
 PhysicsSystem* PhysicsSystem::instance()
@@ -11,99 +15,95 @@ PhysicsSystem* PhysicsSystem::instance()
 	return _instance.get();
 }
 
+CVar physics_hz(			"physics_hz",			"60" );
+CVar physics_max_substeps(	"physics_max_substeps",	"4" );
+
 const glm::vec3 gravity = glm::vec3( 0.f, -40.f, 0.f );
 
 // update clamps for debugging and startup
 const float maxTime = 1.f;
 const float minTime = 0.0001f;
 
-// MllerTrumbore intersection algorithm
-bool RayTriangleIntersection( const glm::vec3& p, const glm::vec3& dir,
-	const std::array<glm::vec3, 3>& triangle, glm::vec3& intersectionPoint )
+bool PhysicsSystem::checkWorldCollision( const E_ID world, const E_ID ent, 
+	const glm::vec3& impulseForces, glm::vec3& forceVector, glm::vec3& velocity )
 {
-	const float EPSILON = 0.00001f;
-
-	glm::vec3 edge1, edge2, h, s, q;
-	float a, f, u, v;
+	// read only, this runs on several threads at once
+	const MeshComponent* mc = EntityManager::instance()->getConst<MeshComponent>( world );
+	const TransformComponent* tc = EntityManager::instance()->getConst<TransformComponent>( ent );
+	const RigidbodyComponent* rbc = EntityManager::instance()->getConst<RigidbodyComponent>( ent );
 
-	edge1 = triangle[1] - triangle[0];
-	edge2 = triangle[2] - triangle[0];
-	h = glm::cross( dir, edge2 );
-	a = glm::dot( edge1, h );
+	forceVector = impulseForces;
 
-	// check if ray is parallel to triangle 
-	if ( std::abs( a ) < EPSILON )
+	// the scene has no world, or it has no mesh yet
+	if ( mc == nullptr )
 	{
 		return false;
 	}
 
-	f = 1.f / a;
-	s = p - triangle[0];
-	u = f * glm::dot( s, h );
-
-	if ( u < 0.f || u > 1.f )
+	const Mesh* m = ResourceManager::instance()->getMesh( mc->mesh );
+	// the world mesh may still be streaming in
+	if ( m == nullptr )
 	{
 		return false;
 	}
 
-	q = glm::cross( s, edge1 );
-	v = f * glm::dot( dir, q );
+	// the capsule hangs down from the position, a height of 0 makes it a sphere
+	const glm::vec3 top = tc->position;
+	const glm::vec3 bottom = tc->position - glm::vec3( 0.f, rbc->height, 0.f );
 
-	if ( v < 0.f || u + v > 1.f )
+	SweepHit hit;
+	if ( !m->bvh.slideCapsule( top, bottom, rbc->radius, impulseForces, forceVector, hit, &velocity, rbc->stepHeight ) )
 	{
 		return false;
 	}
 
-	float t = f * glm::dot( edge2, q );
-	if ( t > EPSILON )
 	{
-		intersectionPoint = p + ( dir * t );
-		return true;
+		std::lock_guard<std::mutex> lock( collisionDebugMutex );
+		const MeshFace& f = m->faces[hit.triangle];
+		collided = true;
+		collisionTriangle = { m->points[f.x], m->points[f.y], m->points[f.z] };
 	}
 
-	return false;
+	return true;
 }
 
-bool PhysicsSystem::checkWorldCollision( const E_ID world, const E_ID ent, 
-	const glm::vec3& impulseForces, glm::vec3& forceVector )
+void PhysicsSystem::updateBroadphase()
 {
-// DEBUG
-	collided = false;
-
-	MeshComponent* mc = EntityManager::instance()->get<MeshComponent>( world );
-	TransformComponent* tc = EntityManager::instance()->get<TransformComponent>( ent );
-	RigidbodyComponent* rc = EntityManager::instance()->get<RigidbodyComponent>( ent );
+	broadphase.clear();
+	broadphaseEntities.clear();
 
-	const Mesh* m = ResourceManager::instance()->getMesh( mc->meshName );
-	
-	for ( const MeshFace f : m->faces )
+	EntityManager::instance()->view<TransformComponent, RigidbodyComponent, ActiveSceneComponent>().each( [&]( E_ID ent,
+		const TransformComponent& tc, const RigidbodyComponent& rbc, const ActiveSceneComponent& )
 	{
-		std::array<glm::vec3, 3> face = {
-			m->points[f.x], m->points[f.y], m->points[f.z]
-		};
-
-		glm::vec3 ip;
-		if ( RayTriangleIntersection( tc->position, glm::normalize( impulseForces ), face, ip ) )
-		{				
-			float glen = glm::length( impulseForces );
-			glm::vec3 delta = ip - tc->position;
-			float iplen = glm::length( delta );
-			
-			// clip the force vector
-			if ( iplen <= glen )
-			{	
-				collided = true;
-				collisionTriangle = face;
-
-				forceVector = glm::vec3( 0.f, 0.f, 0.f );
-				//forceVector = ip - tc->position;
-				return true;
-			}			
+		if ( ent == activeWorld || !rbc.collidable )
+		{
+			return;
 		}
+
+		broadphase.add( tc.position - glm::vec3( rbc.radius, rbc.radius + rbc.height, rbc.radius ),
+			tc.position + glm::vec3( rbc.radius ) );
+		broadphaseEntities.push_back( ent );
+	} );
+
+	bodyPairs.clear();
+	broadphase.findPairs( bodyPairs );
+
+	candidatePairs.clear();
+	for ( const BodyPair& pair : bodyPairs )
+	{
+		candidatePairs.push_back( { broadphaseEntities[pair.a], broadphaseEntities[pair.b] } );
 	}
+}
 
-	forceVector = impulseForces;
-	return false;
+const std::vector<CollisionPair>& PhysicsSystem::getCandidatePairs()
+{
+	if ( broadphaseDirty )
+	{
+		updateBroadphase();
+		broadphaseDirty = false;
+	}
+
+	return candidatePairs;
 }
 
 float CheckClampTime( float time )
@@ -120,53 +120,115 @@ float CheckClampTime( float time )
 	return time;
 }
 
-void PhysicsSystem::update( const float deltaSeconds )
+void PhysicsSystem::step( const E_ID world, const float stepSeconds )
 {
-	Scene* scene = SceneManager::instance()->getActiveScene();
-	if ( !scene )
-	{
-		return;
-	}
-
-	// clamp to a min/max value in case of massive delay (eg.: debugging)
-	float time = CheckClampTime( deltaSeconds );
-
 	EntityManager* em = EntityManager::instance();
 
-	for ( E_ID ent : scene->entities )
+// DEBUG
+	collided = false;
+
+	// only rigidbodies of the active scene are visited, the view is kept up to date by the EntityManager 
+	// and the SceneManager's tags. every entity only touches its own components, so they are spread 
+	// over the worker threads
+	parallelForEach( em->view<TransformComponent, RigidbodyComponent, ActiveSceneComponent>(), [&]( E_ID ent, 
+		TransformComponent& tc, RigidbodyComponent& rbc, ActiveSceneComponent& )
 	{
-		if ( ent == scene->world )
+		if ( ent == world )
 		{
-			continue; // the world is static
+			return; // the world is static
 		}
 
-		RigidbodyComponent* rbc = em->get<RigidbodyComponent>( ent );
-		TransformComponent* tc = em->get<TransformComponent>( ent );
-
-		if ( rbc == nullptr )
+		if ( rbc.affectedByGravity )
 		{
-			continue;
+			rbc.velocity += gravity * stepSeconds;
 		}
 
-		glm::vec3 forces = tc->impulseForces;
-		if ( rbc->affectedByGravity )
-		{
-			forces += deltaSeconds * gravity;
-		}
+		// impulses are displacements of their own, on top of what the velocity covers in the step
+		const glm::vec3 forces = tc.impulseForces + rbc.velocity * stepSeconds;
 
 		glm::vec3 clippedForceVector;
-		if ( rbc->collidable && glm::length(forces) > 0.0001f )
+		if ( rbc.collidable && glm::length(forces) > 0.0001f )
 		{
-			checkWorldCollision( scene->world, ent, forces, clippedForceVector );
+			checkWorldCollision( world, ent, forces, clippedForceVector, rbc.velocity );
 		}
 		else
 		{
 			clippedForceVector = forces;
 		}
 
-		tc->position += clippedForceVector;
-		tc->impulseForces = glm::vec3( 0.f );
+		tc.position += clippedForceVector;
+		tc.impulseForces = glm::vec3( 0.f );
 
-		rbc->velocity = clippedForceVector;
+		if ( clippedForceVector != glm::vec3( 0.f ) )
+		{
+			em->markChanged<TransformComponent>( ent );
+		}
+
+		rbc.stepMotion = clippedForceVector;
+	} );
+
+	broadphaseDirty = true;
+}
+
+void PhysicsSystem::interpolate( const E_ID world, const float alpha )
+{
+	EntityManager* em = EntityManager::instance();
+
+	// the body is drawn alpha of the way through the last step. velocity * stepSeconds would miss 
+	// the impulses and the distance covered before a contact stopped the body
+	parallelForEach( em->view<TransformComponent, RigidbodyComponent, ActiveSceneComponent>(), [&]( E_ID ent, 
+		TransformComponent& tc, RigidbodyComponent& rbc, ActiveSceneComponent& )
+	{
+		const glm::vec3 offset = ent == world ? glm::vec3( 0.f ) : rbc.stepMotion * ( alpha - 1.f );
+		if ( offset != tc.renderOffset )
+		{
+			tc.renderOffset = offset;
+			em->markChanged<TransformComponent>( ent );
+		}
+	} );
+}
+
+void PhysicsSystem::update( const float deltaSeconds )
+{
+	Scene* scene = SceneManager::instance()->getActiveScene();
+	if ( !scene )
+	{
+		return;
+	}
+
+	activeWorld = scene->world;
+
+	// clamp to a min/max value in case of massive delay (eg.: debugging)
+	const float time = CheckClampTime( deltaSeconds );
+
+	// variable step, once per rendered frame
+	if ( physics_hz.floatValue <= 0.f )
+	{
+		accumulator = 0.f;
+		stepsLastUpdate = 1;
+
+		step( scene->world, time );
+		interpolate( scene->world, 1.f );
+		return;
 	}
-};
\ No newline at end of file
+
+	const float stepSeconds = 1.f / physics_hz.floatValue;
+	const int maxSteps = std::max( physics_max_substeps.intValue, 1 );
+
+	accumulator += time;
+	stepsLastUpdate = 0;
+	while ( accumulator >= stepSeconds && stepsLastUpdate < maxSteps )
+	{
+		step( scene->world, stepSeconds );
+		accumulator -= stepSeconds;
+		stepsLastUpdate++;
+	}
+
+	// further behind than the cap allows, drop the backlog instead of spiraling into longer frames
+	if ( accumulator >= stepSeconds )
+	{
+		accumulator = std::fmod( accumulator, stepSeconds );
+	}
+
+	interpolate( scene->world, accumulator / stepSeconds );
+}
\ No newline at end of file
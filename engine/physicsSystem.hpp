@@ -3,21 +3,65 @@
 #include <memory>
 #include <map>
 #include "idManager.hpp"
+#include "utils.hpp"
 #include <glm/glm.hpp>
 #include <array>
+#include <mutex>
+#include <vector>
+#include "collision.hpp"
+
+// two entities whose bounds overlapped in the last update
+struct CollisionPair
+{
+	E_ID a;
+	E_ID b;
+};
 
 class PhysicsSystem
 {
 	static std::unique_ptr<PhysicsSystem> _instance;
 	
+	// sweeps the entity's capsule through the world and slides it along what it hits, 
+	// forceVector is the motion that is left and velocity loses its part into the surfaces
 	bool checkWorldCollision( const E_ID world, const E_ID ent,
-		const glm::vec3& impulseForces,	glm::vec3& forceVector );
+		const glm::vec3& impulseForces,	glm::vec3& forceVector, glm::vec3& velocity );
+
+	// rebuilt from the moved bodies by the first getCandidatePairs() after a step, 
+	// nothing pays for it while nobody asks for pairs
+	SpatialHashGrid				broadphase;
+	std::vector<E_ID>			broadphaseEntities;
+	std::vector<BodyPair>		bodyPairs;
+	std::vector<CollisionPair>	candidatePairs;
+	bool						broadphaseDirty = false;
+	// world of the active scene in the last update
+	E_ID						activeWorld = UNSET_ID;
+
+	void updateBroadphase();
+
+	// time not simulated yet, physics_hz > 0 steps through it in fixed steps
+	float						accumulator = 0.f;
+	int							stepsLastUpdate = 0;
+
+	void step( const E_ID world, const float stepSeconds );
+	// offsets the rendered transforms of the bodies, alpha is how far into the next step the frame is
+	void interpolate( const E_ID world, const float alpha );
 public:
-// debug show which face we hit 
+// debug show which face we hit, entities are updated in parallel so writes go through the mutex
 	bool collided;
 	std::array<glm::vec3, 3> collisionTriangle;
+	std::mutex collisionDebugMutex;
 
 	void update( float deltaSeconds );
 
+	// steps run by the last update, 0 when the frame was shorter than a step
+	int getStepsLastUpdate() const
+	{
+		return stepsLastUpdate;
+	}
+
+	// input of the entity vs entity narrowphase, bodies of the active scene whose bounds 
+	// overlap after the last update. main thread only, not while update() runs
+	const std::vector<CollisionPair>& getCandidatePairs();
+
 	static PhysicsSystem* instance();
 };
\ No newline at end of file
@@ -13,6 +13,8 @@ PlayerController* PlayerController::instance()
 }
 
 const float moveSpeed = 1.f;
+// units per second, under the physics gravity it peaks about 60 units up
+const float jumpSpeed = 70.f;
 
 
 float Angle( const glm::vec2& base, const glm::vec2 v )
@@ -33,6 +35,7 @@ glm::vec3 CalcEulerAngles( glm::vec3 orientation )
 
 bool PlayerController::setPosition( glm::vec3 position )
 {
+	TransformComponent* transform = getTransform();
 	if ( transform )
 	{
 		transform->position = position;
@@ -45,6 +48,7 @@ bool PlayerController::setPosition( glm::vec3 position )
 
 bool PlayerController::setFacingDirection( glm::vec3 direction )
 {
+	TransformComponent* transform = getTransform();
 	if ( transform )
 	{
 		transform->facingDirection = glm::vec3( direction.x, direction.y, direction.z );
@@ -57,6 +61,7 @@ bool PlayerController::setFacingDirection( glm::vec3 direction )
 
 bool PlayerController::displace( glm::vec3 movement )
 {
+	TransformComponent* transform = getTransform();
 	if ( transform )
 	{
 		transform->position += movement;
@@ -67,17 +72,20 @@ bool PlayerController::displace( glm::vec3 movement )
 	return false;
 }
 
+TransformComponent* PlayerController::getTransform() const
+{
+	return EntityManager::instance()->get<TransformComponent>( attachedEntity );
+}
+
 void PlayerController::setEntity( const E_ID id )
 {	
 	if ( EntityManager::instance()->isIdValid( id ) )
 	{
 		attachedEntity = id;
-		transform = EntityManager::instance()->get<TransformComponent>( id );
 	}
 	else
 	{
 		attachedEntity = UNSET_ID;
-		transform = nullptr;
 	}
 }
 
@@ -109,6 +117,7 @@ bool PlayerController::backward()
 
 bool PlayerController::strafeLeft()
 {
+	TransformComponent* transform = getTransform();
 	if ( transform )
 	{
 		glm::vec3 strafe = glm::cross( transform->facingDirection,
@@ -124,6 +133,7 @@ bool PlayerController::strafeLeft()
 
 bool PlayerController::strafeRight()
 {	
+	TransformComponent* transform = getTransform();
 	if ( transform )
 	{
 		glm::vec3 strafe = glm::cross( transform->facingDirection,
@@ -140,6 +150,7 @@ bool PlayerController::strafeRight()
 // todo: EVERYTHING in here
 bool PlayerController::turn( glm::vec2 delta )
 {
+	TransformComponent* transform = getTransform();
 	if ( transform )
 	{
 		glm::vec3 rot;
@@ -178,12 +189,16 @@ bool PlayerController::turn( glm::vec2 delta )
 
 bool PlayerController::jump()
 {
+	TransformComponent* transform = getTransform();
 	if ( transform )
 	{
-		RigidbodyComponent* rbc =  EntityManager::instance()->get<RigidbodyComponent>( attachedEntity );
+		// a launch speed instead of an impulse, pressing again before the next physics step 
+		// finds the body already moving up and does not stack up a higher jump
+		EntityManager* em = EntityManager::instance();
+		const RigidbodyComponent* rbc = em->getConst<RigidbodyComponent>( attachedEntity );
 		if ( rbc && std::abs( rbc->velocity.y ) < 0.001f )
 		{
-			transform->impulseForces += glm::vec3( 0.f, 60.f, 0.f );
+			em->get<RigidbodyComponent>( attachedEntity )->velocity.y = jumpSpeed;
 			return true;
 		}
 	}
@@ -10,8 +10,9 @@ class TransformComponent;
 class PlayerController
 {
 	E_ID attachedEntity = UNSET_ID;
-// cache this here since most functions need it 
-	TransformComponent* transform = nullptr;
+
+// component storage is packed and may move, so don't hold on to the pointer 
+	TransformComponent* getTransform() const;
 
 	static std::unique_ptr<PlayerController> _instance;
 public:
@@ -8,6 +8,7 @@
 #include "components.hpp"
 #include "sceneManager.hpp"
 #include "resourceManager.hpp"
+#include "parallel.hpp"
 
 #include <set>
 #include <string>
@@ -481,7 +482,7 @@ glm::mat4x4 GetModelMatrix( TransformComponent* transform )
 	glm::mat4x4 model( 1.f );
 	
 	// displacement
-	glm::mat4 translation = glm::translate( model, transform->position );
+	glm::mat4 translation = glm::translate( model, transform->position + transform->renderOffset );
 	
 	// uint64_t frameCount = Renderer::instance()->renderedFrameCount;
 	// float angle = float( frameCount % ( 3600 ) ) / 10.f;
@@ -499,12 +500,42 @@ glm::mat4x4 GetModelMatrix( TransformComponent* transform )
 
 const VulkanTexture* Renderer::getTexture( const std::string& name ) const
 {
-	if ( textures.count( name ) == 0 )
+	return getTexture( ResourceManager::instance()->findTextureHandle( name ) );
+}
+
+const VulkanTexture* Renderer::getTexture( const TextureHandle handle ) const
+{
+	auto loaded = [this]( const TextureHandle h )
 	{
-		return &textures.at( "notexture" );
+		return h < textures.size() && textures[h].image != VK_NULL_HANDLE;
+	};
+
+	if ( loaded( handle ) )
+	{
+		return &textures[handle];
 	}
 
-	return &textures.at( name );
+	// "notexture" stands in for textures that aren't loaded, nothing if it failed to load too
+	return loaded( missingTexture ) ? &textures[missingTexture] : nullptr;
+}
+
+void Renderer::updateModelMatrices()
+{
+	EntityManager* em = EntityManager::instance();
+
+	// matrices are independent per entity, build them on the workers before recording.
+	// only transforms written since the last pass are rebuilt, static props keep theirs. 
+	// a new mesh brings its entity into the view with whatever matrix it had, so it counts too
+	const uint32_t since = matrixTick;
+	parallelForEach( em->view<TransformComponent, MeshComponent>(), [em, since]( E_ID ent, 
+		TransformComponent& tc, MeshComponent& )
+	{
+		if ( em->changedSince<TransformComponent>( ent, since ) || em->changedSince<MeshComponent>( ent, since ) )
+		{
+			tc.modelMatrix = GetModelMatrix( &tc );
+		}
+	} );
+	matrixTick = em->getChangeTick();
 }
 
 void Renderer::draw()
@@ -532,24 +563,31 @@ void Renderer::draw()
 		return;
 	}
 
+	updateModelMatrices();
+
 	for ( auto& ent : SceneManager::instance()->getActiveScene()->entities )
 	{
-		MeshComponent* meshComponent = em->get<MeshComponent>( ent );
-		if ( !meshComponent || meshComponent->meshName == UNSET_S )
+		const MeshComponent* meshComponent = em->getConst<MeshComponent>( ent );
+		if ( !meshComponent || meshComponent->mesh >= models.size() )
+		{
+			continue;
+		}
+
+		const Mesh* mesh				= rm->getMesh( meshComponent->mesh );
+		if ( mesh == nullptr )
 		{
 			continue;
 		}
 
-		const Mesh* mesh				= rm->getMesh( meshComponent->meshName );
-		const RenderModel& model		= models[meshComponent->meshName];
+		const RenderModel& model		= models[meshComponent->mesh];
 
 		offsets[0]						= model.vertexOffset;
 		transformOffset					= modelMatrixBuffer.offset;
 
 		glm::mat4x4* modelMatrix		= ( glm::mat4x4* )modelMatrixBuffer.allocate( sizeof( glm::mat4x4 ) );
-		*modelMatrix					= GetModelMatrix( em->get<TransformComponent>( ent ) );
+		*modelMatrix					= em->getConst<TransformComponent>( ent )->modelMatrix;
 		
-		if ( meshComponent->meshName != "nullmesh" )
+		if ( meshComponent->mesh != nullMesh )
 		{
 			vkCmdBindPipeline( cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline );
 		}
@@ -566,7 +604,12 @@ void Renderer::draw()
 			dynamicIndexBuffer.offset = 0;
 			for ( const auto& tex : mesh->materialFaceIndexRanges )
 			{
-				const VulkanTexture* texture = getTexture( tex.matName );
+				const VulkanTexture* texture = getTexture( tex.texture );
+				if ( texture == nullptr )
+				{
+					continue;
+				}
+
 				VkDeviceSize oldOffset = dynamicIndexBuffer.offset;
 				size_t mallocBytes = tex.range * sizeof( uint32_t );
 				void* mem = dynamicIndexBuffer.allocate( mallocBytes );
@@ -582,9 +625,13 @@ void Renderer::draw()
 		}
 		else
 		{
-			vkCmdBindIndexBuffer( cmdBuf, indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32 );
+			const VulkanTexture* texture = getTexture( meshComponent->texture );
+			if ( texture == nullptr )
+			{
+				continue;
+			}
 
-			const VulkanTexture* texture = getTexture( meshComponent->textureName );
+			vkCmdBindIndexBuffer( cmdBuf, indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32 );
 
 			vkCmdBindDescriptorSets( cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout,
 				0, 1, &texture->descriptor, 0, nullptr );
@@ -839,7 +886,13 @@ void Renderer::loadTexture( const std::string& name )
 	std::memcpy( stagingBuffer.data, img->colorData.data(), img->colorData.size() );
 	stagingBuffer.unmap();
 
-	VulkanTexture& texture = textures[name];
+	TextureHandle handle = rm->getTextureHandle( name );
+	if ( handle >= textures.size() )
+	{
+		textures.resize( handle + 1 );
+	}
+
+	VulkanTexture& texture = textures[handle];
 
 	CreateImageProperties imageProps = {};
 	imageProps.format	= VK_FORMAT_R8G8B8A8_UNORM;
@@ -980,7 +1033,8 @@ VkResult Renderer::createDepthResources()
 
 void Renderer::loadModel( const std::string& objName )
 {
-	const Mesh* mesh = ResourceManager::instance()->getMesh( objName );
+	MeshHandle handle = ResourceManager::instance()->getMeshHandle( objName );
+	const Mesh* mesh = ResourceManager::instance()->getMesh( handle );
 	RenderModel renderModel = {};
 	stagingBuffer.offset = 0;
 
@@ -1009,7 +1063,12 @@ void Renderer::loadModel( const std::string& objName )
 	renderModel.indexOffset = indexOffset;
 	renderModel.indexCount = (uint32_t)mesh->indicies.size();
 
-	models[objName] = renderModel;
+	if ( handle >= models.size() )
+	{
+		models.resize( handle + 1 );
+	}
+
+	models[handle] = renderModel;
 }
 
 void Renderer::childInit() {}
@@ -1018,6 +1077,9 @@ void Renderer::childShutdown() {}
 void Renderer::init()
 {
 	renderedFrameCount = 0;
+
+	missingTexture	= ResourceManager::instance()->getTextureHandle( "notexture" );
+	nullMesh		= ResourceManager::instance()->getMeshHandle( "nullmesh" );
 	
 	VKCHECK( createVkInstance() );
 
@@ -1074,10 +1136,16 @@ void Renderer::shutdown()
 
 	for ( auto& it : textures )
 	{
-		vkDestroyImageView( device.logicalDevice, it.second.view, nullptr );
-		vkDestroyImage( device.logicalDevice, it.second.image, nullptr );
-		vkFreeMemory( device.logicalDevice, it.second.memory, nullptr );
+		if ( it.image == VK_NULL_HANDLE )
+		{
+			continue;
+		}
+
+		vkDestroyImageView( device.logicalDevice, it.view, nullptr );
+		vkDestroyImage( device.logicalDevice, it.image, nullptr );
+		vkFreeMemory( device.logicalDevice, it.memory, nullptr );
 	}
+	textures.clear();
 	
 	vkDestroyImageView( device.logicalDevice, depthImageView, nullptr );
 	vkDestroyImage( device.logicalDevice, depthImage, nullptr );
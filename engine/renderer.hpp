@@ -2,6 +2,7 @@
 
 #include <memory>
 #include <map>
+#include <vector>
 
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
@@ -15,6 +16,7 @@
 #include "debugOverlay.hpp"
 
 #include "idManager.hpp"
+#include "utils.hpp"
 
 struct Mesh;
 
@@ -55,6 +57,8 @@ protected:
 	uint32_t						currentImageIndex;
 
 	const VulkanTexture*			getTexture( const std::string& name ) const;
+	// falls back to the "notexture" placeholder for unloaded textures
+	const VulkanTexture*			getTexture( const TextureHandle handle ) const;
 
 	// begins the main rederpass 
 	void							beginDraw();
@@ -144,8 +148,9 @@ protected:
 	VkResult						createDescriptorPool();
 	VkResult						createUBODescritptorSet();
 	
-// texture loading
-	std::map<std::string, VulkanTexture> textures;
+// texture loading, indexed by TextureHandle
+	std::vector<VulkanTexture>		textures;
+	TextureHandle					missingTexture;
 
 	VkSampler						textureSampler;
 	VkResult						createTextureSampler();
@@ -159,8 +164,11 @@ protected:
 										VkImageTiling tiling, VkFormatFeatureFlags features );
 	VkResult						createDepthResources();
 
-// models 
-	std::map<std::string, RenderModel>	models;	
+// models, indexed by MeshHandle
+	std::vector<RenderModel>		models;
+	MeshHandle						nullMesh;
+	// EntityManager change tick of the last model matrix pass
+	uint32_t						matrixTick = 0;
 public:
 	GLFWwindow*						window;
 	uint64_t						renderedFrameCount;
@@ -169,6 +177,10 @@ public:
 	virtual void					drawFrame();
 	void							shutdown();
 
+	// rebuilds the model matrices of the transforms and meshes written since the last call, 
+	// draw() runs it every frame
+	void							updateModelMatrices();
+
 	void							loadModel( const std::string& objName );
 	void							loadTexture( const std::string& name );
 
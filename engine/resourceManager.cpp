@@ -12,6 +12,27 @@ ResourceManager* ResourceManager::instance()
 	return _instance.get();
 }
 
+uint32_t NameTable::intern( const std::string& name )
+{
+	auto it = handles.find( name );
+	if ( it != handles.end() )
+	{
+		return it->second;
+	}
+
+	uint32_t handle = (uint32_t)names.size();
+	handles[name] = handle;
+	names.push_back( name );
+
+	return handle;
+}
+
+uint32_t NameTable::find( const std::string& name ) const
+{
+	auto it = handles.find( name );
+	return it != handles.end() ? it->second : UNSET_HANDLE;
+}
+
 bool ResourceManager::loadImage( const std::string& path, const std::string& imgName )
 {
 	if( !FileSystem::CheckFileExists( path ) )
@@ -20,24 +41,55 @@ bool ResourceManager::loadImage( const std::string& path, const std::string& img
 		return false;
 	}
 	   
-	ImageInfo ii = FileSystem::LoadImage( path );
+	addImage( imgName, path, FileSystem::LoadImage( path ) );
 
+	return true;
+}
+
+void ResourceManager::addImage( const std::string& imgName, const std::string& path, ImageInfo&& image )
+{
 	Image& tex = images[imgName];
 	tex.filename = path;
-	tex.width = ii.width;
-	tex.height = ii.height;
+	tex.width = image.width;
+	tex.height = image.height;
 	tex.pixelDepth = 32; // fix in the engine 
 	
-	size_t size = ii.bytes.size();
+	size_t size = image.bytes.size();
 	tex.colorData.resize( size );
-	std::memcpy( tex.colorData.data(), ii.bytes.data(), 
+	std::memcpy( tex.colorData.data(), image.bytes.data(), 
 		size * sizeof( uint8_t ) );
-
-	return true;
 }
 
 bool ResourceManager::loadMesh( const std::string& path, const std::string& objName,
 	const std::string& materialPath )
+{
+	std::unique_ptr<Mesh> mesh = readMesh( path, materialPath );
+	if ( !mesh )
+	{
+		return false;
+	}
+
+	addMesh( objName, std::move( mesh ) );
+	return true;
+}
+
+void ResourceManager::addMesh( const std::string& objName, std::unique_ptr<Mesh> mesh )
+{
+	for ( MaterialRange& range : mesh->materialFaceIndexRanges )
+	{
+		range.texture = getTextureHandle( range.matName );
+	}
+
+	MeshHandle handle = getMeshHandle( objName );
+	if ( handle >= meshes.size() )
+	{
+		meshes.resize( handle + 1 );
+	}
+
+	meshes[handle] = std::move( mesh );
+}
+
+std::unique_ptr<Mesh> ResourceManager::readMesh( const std::string& path, const std::string& materialPath )
 {
 	tinyobj::attrib_t					attribute;
 	std::vector<tinyobj::shape_t>		shapes;
@@ -50,7 +102,7 @@ bool ResourceManager::loadMesh( const std::string& path, const std::string& objN
 	if ( !error.empty() )
 	{
 		Logger::PrintToOutputWindow( "Load Mesh Error: %s", error.c_str() );
-		return false;
+		return nullptr;
 	}
 
 	if ( !warning.empty() )
@@ -58,7 +110,8 @@ bool ResourceManager::loadMesh( const std::string& path, const std::string& objN
 		Logger::PrintToOutputWindow( "Load Mesh Warning: %s", warning.c_str() );
 	}
 	
-	Mesh& mesh = meshes[objName];
+	std::unique_ptr<Mesh> result = std::make_unique<Mesh>();
+	Mesh& mesh = *result;
 
 	size_t indexOffset = 0;
 	for ( const auto& shape : shapes )
@@ -162,8 +215,18 @@ bool ResourceManager::loadMesh( const std::string& path, const std::string& objN
 			}
 		}		
 	}
+
+	// any mesh can be a scene's world, the tree is built here so streaming does it on a worker
+	std::vector<std::array<glm::vec3, 3>> triangles;
+	triangles.reserve( mesh.faces.size() );
+	for ( const MeshFace& f : mesh.faces )
+	{
+		triangles.push_back( { mesh.points[f.x], mesh.points[f.y], mesh.points[f.z] } );
+	}
+
+	mesh.bvh.build( triangles );
 	
-	return true;
+	return result;
 }
 
 const Image* ResourceManager::getImage( const std::string& name ) const
@@ -178,15 +241,43 @@ const Image* ResourceManager::getImage( const std::string& name ) const
 
 const Mesh* ResourceManager::getMesh( const std::string& name ) const
 {
-	if ( meshes.count( name ) == 0 )
-	{
-		return nullptr;
-	}
+	return getMesh( findMeshHandle( name ) );
+}
+
+MeshHandle ResourceManager::getMeshHandle( const std::string& name )
+{
+	return name == UNSET_S ? UNSET_HANDLE : meshNames.intern( name );
+}
+
+TextureHandle ResourceManager::getTextureHandle( const std::string& name )
+{
+	return name == UNSET_S ? UNSET_HANDLE : textureNames.intern( name );
+}
+
+MeshHandle ResourceManager::findMeshHandle( const std::string& name ) const
+{
+	return meshNames.find( name );
+}
 
-	return &meshes.at( name );
+TextureHandle ResourceManager::findTextureHandle( const std::string& name ) const
+{
+	return textureNames.find( name );
+}
+
+const std::string& ResourceManager::getMeshName( const MeshHandle handle ) const
+{
+	static const std::string unset = UNSET_S;
+	return handle < meshNames.names.size() ? meshNames.names[handle] : unset;
+}
+
+const std::string& ResourceManager::getTextureName( const TextureHandle handle ) const
+{
+	static const std::string unset = UNSET_S;
+	return handle < textureNames.names.size() ? textureNames.names[handle] : unset;
 }
 
 void ResourceManager::shutdown()
 {
 	images.clear();
+	meshes.clear();
 }
\ No newline at end of file
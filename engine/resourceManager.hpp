@@ -5,6 +5,8 @@
 #include <memory>
 #include <glm/glm.hpp>
 #include "utils.hpp"
+#include "collision.hpp"
+#include "fileSystem.hpp"
 #include "vulkanVertex.hpp"
 
 // Holds pixel RGBA data that can directly be loaded into the renderer
@@ -22,6 +24,8 @@ struct Image
 struct MaterialRange
 {
 	std::string matName = UNSET_S;
+	// matName resolved when the mesh is loaded
+	TextureHandle texture = UNSET_HANDLE;
 	// staring Mesh::faces index 
 	uint32_t	start = 0;
 	// number of Mesh::faces elements
@@ -62,25 +66,64 @@ struct Mesh
 // Use these for physics
 	std::vector<MeshFace>		faces;
 	std::vector<glm::vec3>		points;
+	// over faces, hits report Mesh::faces indices
+	BVH							bvh;
 
 // bounding box range 
 	glm::vec3 topLeftNear;
 	glm::vec3 botRightFar;
 };
 
+/*
+	Names are interned into handles the first time they are seen, even 
+	before the resource is loaded. Handles are indices, so per-frame 
+	lookups are array accesses instead of string map searches.
+*/
+struct NameTable
+{
+	std::map<std::string, uint32_t>	handles;
+	std::vector<std::string>		names;
+
+	uint32_t intern( const std::string& name );
+	uint32_t find( const std::string& name ) const;
+};
+
 class ResourceManager
 {
 	static std::unique_ptr<ResourceManager> _instance;
 	
-	std::map<std::string, Image>	images;
-	std::map<std::string, Mesh>		meshes;
+	std::map<std::string, Image>		images;
+	// indexed by MeshHandle, null until the mesh is loaded
+	std::vector<std::unique_ptr<Mesh>>	meshes;
+
+	NameTable							meshNames;
+	NameTable							textureNames;
 public:
 
 	bool loadImage( const std::string& path, const std::string& imgName );
 	bool loadMesh( const std::string& path, const std::string& objName, const std::string& materialPath = "" );
 
+	// loading split in two for streaming: read* only touches the file and is safe 
+	// to call from any thread, add* registers the result and belongs to the main thread
+	static std::unique_ptr<Mesh> readMesh( const std::string& path, const std::string& materialPath = "" );
+	void addMesh( const std::string& objName, std::unique_ptr<Mesh> mesh );
+	void addImage( const std::string& imgName, const std::string& path, ImageInfo&& image );
+
+	// interns names it hasn't seen yet, for assigning them to components
+	MeshHandle getMeshHandle( const std::string& name );
+	TextureHandle getTextureHandle( const std::string& name );
+	// lookups only, UNSET_HANDLE for unknown names
+	MeshHandle findMeshHandle( const std::string& name ) const;
+	TextureHandle findTextureHandle( const std::string& name ) const;
+	const std::string& getMeshName( const MeshHandle handle ) const;
+	const std::string& getTextureName( const TextureHandle handle ) const;
+
 	const Image* getImage( const std::string& name ) const;
 	const Mesh* getMesh( const std::string& name ) const;
+	const Mesh* getMesh( const MeshHandle handle ) const
+	{
+		return handle < meshes.size() ? meshes[handle].get() : nullptr;
+	}
 
 	void shutdown();
 	static ResourceManager* instance();
@@ -1,4 +1,6 @@
 #include "sceneManager.hpp"
+#include "entityManager.hpp"
+#include "components.hpp"
 
 std::unique_ptr<SceneManager> SceneManager::_instance = std::make_unique<SceneManager>();
 
@@ -40,7 +42,9 @@ Scene* SceneManager::setActiveScene( SC_ID id )
 	{
 		fireSceneEvents( enu_EVENT_TYPE::scene_leave );
 
+		tagEntities( getActiveScene(), false );
 		activeScene = id;
+		tagEntities( getActiveScene(), true );
 		
 		fireSceneEvents( enu_EVENT_TYPE::scene_enter );
 	}
@@ -70,6 +74,44 @@ Scene* SceneManager::getScene( const std::string& name )
 	return nullptr;
 }	
 
+void SceneManager::addEntityToScene( SC_ID id, E_ID ent )
+{
+	Scene* scene = getScene( id );
+	EntityManager* em = EntityManager::instance();
+	if ( scene == nullptr || !em->isIdValid( ent ) )
+	{
+		return;
+	}
+
+	scene->entities.push_back( em->resolveId( ent ) );
+	if ( id == activeScene )
+	{
+		em->add<ActiveSceneComponent>( ent );
+	}
+}
+
+void SceneManager::tagEntities( Scene* scene, bool active )
+{
+	if ( scene == nullptr )
+	{
+		return;
+	}
+
+	// removed entities stay in the list, their stored generation keeps them from tagging a reused slot
+	EntityManager* em = EntityManager::instance();
+	for ( const E_ID ent : scene->entities )
+	{
+		if ( active )
+		{
+			em->add<ActiveSceneComponent>( ent );
+		}
+		else
+		{
+			em->remove<ActiveSceneComponent>( ent );
+		}
+	}
+}
+
 void SceneManager::fireSceneEvents( enu_EVENT_TYPE type )
 {
 	if ( activeScene != UNSET_ID )
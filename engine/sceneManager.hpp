@@ -16,6 +16,9 @@ class SceneManager
 	
 	std::map<SC_ID, std::unique_ptr<Scene>> scenes;
 	std::map<std::string, SC_ID>			namedScenes;
+
+	// adds or removes the ActiveSceneComponent of the scene's live entities
+	void tagEntities( Scene* scene, bool active );
 public:
 	SC_ID addScene( const std::string& name );
 	void destroyScene( SC_ID id );
@@ -24,6 +27,10 @@ public:
 	Scene* getScene( SC_ID id );
 	Scene* getScene( const std::string& name );
 
+	// stores the id with its generation, so a removed entity's slot handed to another 
+	// entity does not join the scene. Entities of the active scene are tagged right away
+	void addEntityToScene( SC_ID id, E_ID ent );
+
 	void fireSceneEvents( enu_EVENT_TYPE type );
 	void shutdown();
 
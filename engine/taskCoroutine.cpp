@@ -0,0 +1,72 @@
+#include "taskCoroutine.hpp"
+#include "fileSystem.hpp"
+
+ResumeTask::ResumeTask( std::coroutine_handle<> handle, const enu_TASK_PRIORITY taskPriority )
+	: handle( handle )
+{
+	rangeSize = 1;
+	priority = taskPriority;
+	deleteWhenDone = true;
+	name = "coroutine";
+}
+
+void ResumeTask::execute( const TaskRange& range )
+{
+	handle.resume();
+}
+
+// reads the file for a FileReadAwaiter, then resumes the coroutine waiting for it
+class FileReadTask : public RangedTask
+{
+	FileReadAwaiter*		awaiter;
+	std::coroutine_handle<>	handle;
+public:
+	FileReadTask( FileReadAwaiter* awaiter, std::coroutine_handle<> handle )
+		: awaiter( awaiter ), handle( handle )
+	{
+		rangeSize = 1;
+		priority = enu_TASK_PRIORITY::background;
+		deleteWhenDone = true;
+		name = "readFile";
+	}
+
+	void execute( const TaskRange& range ) override
+	{
+		if ( FileSystem::CheckFileExists( awaiter->path ) )
+		{
+			awaiter->bytes = FileSystem::ReadBinaryFile( awaiter->path );
+		}
+
+		handle.resume();
+	}
+};
+
+void WorkerAwaiter::await_suspend( std::coroutine_handle<> handle )
+{
+	TaskScheduler::instance()->execute( new ResumeTask( handle, priority ) );
+}
+
+void NextFrameAwaiter::await_suspend( std::coroutine_handle<> handle )
+{
+	TaskScheduler::instance()->runOnMainThread( [handle]() { handle.resume(); } );
+}
+
+void FileReadAwaiter::await_suspend( std::coroutine_handle<> handle )
+{
+	TaskScheduler::instance()->execute( new FileReadTask( this, handle ) );
+}
+
+WorkerAwaiter resumeOnWorkers( const enu_TASK_PRIORITY priority )
+{
+	return { priority };
+}
+
+NextFrameAwaiter nextFrame()
+{
+	return {};
+}
+
+FileReadAwaiter readFile( const std::string& path )
+{
+	return { path };
+}
\ No newline at end of file
@@ -0,0 +1,351 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <utility>
+#include <optional>
+#include <exception>
+#include <coroutine>
+#include <type_traits>
+
+#include "taskFuture.hpp"
+
+// everything a Task's promise needs independent of the result type
+class TaskPromiseBase
+{
+public:
+	// resumed when the task finishes, set by whoever co_awaits it
+	std::coroutine_handle<>	continuation;
+	// spawned tasks have no owner and free their frame when they finish
+	bool					detached = false;
+	// thrown out of the task's body, rethrown where the task is co_awaited
+	std::exception_ptr		exception;
+
+	struct FinalAwaiter
+	{
+		bool await_ready() noexcept
+		{
+			return false;
+		}
+
+		template <typename P> std::coroutine_handle<> await_suspend( std::coroutine_handle<P> handle ) noexcept
+		{
+			TaskPromiseBase& promise = handle.promise();
+			std::coroutine_handle<> next = promise.continuation ? promise.continuation : std::noop_coroutine();
+
+			if ( promise.detached )
+			{
+				handle.destroy();
+			}
+
+			return next;
+		}
+
+		void await_resume() noexcept {}
+	};
+
+	// tasks don't run until they are awaited or spawned
+	std::suspend_always initial_suspend() noexcept
+	{
+		return {};
+	}
+
+	FinalAwaiter final_suspend() noexcept
+	{
+		return {};
+	}
+
+	// the task finishes with the exception instead of a result
+	void unhandled_exception()
+	{
+		exception = std::current_exception();
+	}
+};
+
+template <typename T> class TaskPromise : public TaskPromiseBase
+{
+public:
+	std::optional<T> value;
+
+	Task<T> get_return_object();
+
+	template <typename U> void return_value( U&& v )
+	{
+		value.emplace( std::forward<U>( v ) );
+	}
+};
+
+template <> class TaskPromise<void> : public TaskPromiseBase
+{
+public:
+	Task<void> get_return_object();
+
+	void return_void() {}
+};
+
+/*
+	Task - a coroutine that runs on whatever thread resumes it.
+
+	A task starts when it is co_awaited by another task or handed to
+	spawn(), and runs on the calling thread until its first suspension.
+	The awaitables below move it between threads:
+
+		co_await resumeOnWorkers();		continue on a TaskScheduler worker
+		co_await nextFrame();			continue on the main thread at the next
+										runMainThreadTasks() call
+		co_await readFile( path );		read the file on a background worker,
+										continue there with its bytes
+		co_await future;				continue once a TaskFuture is ready
+		co_await task;					run another Task and continue with its result
+
+	Loading code can read and decode on the workers and come back to the
+	main thread for the resource tables and the gpu upload, without the
+	main loop ever waiting for it.
+
+	An exception leaving a task is rethrown where it is co_awaited, the 
+	future of a spawned task and syncWait() rethrow it like the futures 
+	of submit() do. co_await on a failed future throws in the task.
+*/
+template <typename T> class [[nodiscard]] Task
+{
+	template <typename U> friend TaskFuture<U> spawn( Task<U> task );
+public:
+	using promise_type = TaskPromise<T>;
+private:
+	std::coroutine_handle<promise_type> handle;
+public:
+	explicit Task( std::coroutine_handle<promise_type> handle ) : handle( handle ) {}
+	Task( Task&& other ) noexcept : handle( std::exchange( other.handle, nullptr ) ) {}
+	Task& operator=( Task&& other ) noexcept
+	{
+		if ( this != &other )
+		{
+			if ( handle )
+			{
+				handle.destroy();
+			}
+			handle = std::exchange( other.handle, nullptr );
+		}
+		return *this;
+	}
+	Task( const Task& ) = delete;
+	Task& operator=( const Task& ) = delete;
+
+	~Task()
+	{
+		if ( handle )
+		{
+			handle.destroy();
+		}
+	}
+
+	bool done() const
+	{
+		return !handle || handle.done();
+	}
+
+	auto operator co_await() noexcept
+	{
+		struct Awaiter
+		{
+			std::coroutine_handle<promise_type> handle;
+
+			bool await_ready() noexcept
+			{
+				return !handle || handle.done();
+			}
+
+			// starts the awaited task right away on this thread
+			std::coroutine_handle<> await_suspend( std::coroutine_handle<> awaiting ) noexcept
+			{
+				handle.promise().continuation = awaiting;
+				return handle;
+			}
+
+			T await_resume()
+			{
+				if ( handle.promise().exception )
+				{
+					std::rethrow_exception( handle.promise().exception );
+				}
+
+				if constexpr ( !std::is_void_v<T> )
+				{
+					return std::move( *handle.promise().value );
+				}
+			}
+		};
+
+		return Awaiter{ handle };
+	}
+};
+
+template <typename T> Task<T> TaskPromise<T>::get_return_object()
+{
+	return Task<T>( std::coroutine_handle<TaskPromise<T>>::from_promise( *this ) );
+}
+
+inline Task<void> TaskPromise<void>::get_return_object()
+{
+	return Task<void>( std::coroutine_handle<TaskPromise<void>>::from_promise( *this ) );
+}
+
+// resumes a coroutine on a worker, owned by the scheduler
+class ResumeTask : public RangedTask
+{
+	std::coroutine_handle<> handle;
+public:
+	ResumeTask( std::coroutine_handle<> handle, const enu_TASK_PRIORITY taskPriority );
+
+	void execute( const TaskRange& range ) override;
+};
+
+struct WorkerAwaiter
+{
+	enu_TASK_PRIORITY priority;
+
+	bool await_ready() noexcept
+	{
+		return false;
+	}
+
+	void await_suspend( std::coroutine_handle<> handle );
+	void await_resume() noexcept {}
+};
+
+struct NextFrameAwaiter
+{
+	bool await_ready() noexcept
+	{
+		return false;
+	}
+
+	void await_suspend( std::coroutine_handle<> handle );
+	void await_resume() noexcept {}
+};
+
+struct FileReadAwaiter
+{
+	std::string			path;
+	std::vector<char>	bytes;
+
+	bool await_ready() noexcept
+	{
+		return false;
+	}
+
+	void await_suspend( std::coroutine_handle<> handle );
+	// empty if the file couldn't be read
+	std::vector<char> await_resume()
+	{
+		return std::move( bytes );
+	}
+};
+
+template <typename T> struct FutureAwaiter
+{
+	const TaskFuture<T>& future;
+
+	bool await_ready() const
+	{
+		return future.isReady();
+	}
+
+	void await_suspend( std::coroutine_handle<> handle )
+	{
+		future.onReady( [handle]() { handle.resume(); } );
+	}
+
+	// the future is ready, get() and wait() don't block and rethrow what it failed with
+	decltype( auto ) await_resume() const
+	{
+		if constexpr ( !std::is_void_v<T> )
+		{
+			return future.get();
+		}
+		else
+		{
+			future.wait();
+		}
+	}
+};
+
+// the result stays in the future, the awaiting expression has to keep it alive
+template <typename T> FutureAwaiter<T> operator co_await( const TaskFuture<T>& future )
+{
+	return { future };
+}
+
+WorkerAwaiter resumeOnWorkers( const enu_TASK_PRIORITY priority = enu_TASK_PRIORITY::frame );
+NextFrameAwaiter nextFrame();
+FileReadAwaiter readFile( const std::string& path );
+
+template <typename T> Task<void> spawnRunner( Task<T> task, std::shared_ptr<FutureState<T>> state )
+{
+	// nobody awaits the runner, the task's exception goes to the future
+	try
+	{
+		if constexpr ( std::is_void_v<T> )
+		{
+			co_await task;
+		}
+		else
+		{
+			state->value.emplace( co_await task );
+		}
+	}
+	catch ( ... )
+	{
+		state->exception = std::current_exception();
+	}
+
+	state->markReady();
+}
+
+// starts the task on the calling thread without waiting for it, the future reports its end
+template <typename T> TaskFuture<T> spawn( Task<T> task )
+{
+	std::shared_ptr<FutureState<T>> state = std::make_shared<FutureState<T>>();
+
+	Task<void> runner = spawnRunner( std::move( task ), state );
+	std::coroutine_handle<TaskPromise<void>> handle = std::exchange( runner.handle, nullptr );
+	handle.promise().detached = true;
+	handle.resume();
+
+	return TaskFuture<T>( state );
+}
+
+/*
+	runs the task to the end and returns its result, for code that can't be
+	a coroutine itself. Main thread only: it keeps running the main thread
+	queue, so tasks waiting for nextFrame() still make progress. Rethrows 
+	what the task threw.
+*/
+template <typename T> T syncWait( Task<T> task )
+{
+	TaskFuture<T> future = spawn( std::move( task ) );
+	TaskScheduler* ts = TaskScheduler::instance();
+
+	// the end of the task queues a no-op for the main thread, so sleeping on 
+	// that queue wakes up for the result as well as for nextFrame() work
+	future.onReady( [ts]() { ts->runOnMainThread( []() {} ); } );
+
+	while ( !future.isReady() )
+	{
+		if ( ts->runMainThreadTasks() == 0 && !ts->runPendingTask() )
+		{
+			ts->waitForMainThreadTasks();
+		}
+	}
+
+	if constexpr ( !std::is_void_v<T> )
+	{
+		return future.get();
+	}
+	else
+	{
+		future.wait();
+	}
+}
\ No newline at end of file
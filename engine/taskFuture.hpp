@@ -0,0 +1,322 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <cassert>
+#include <exception>
+#include <vector>
+#include <utility>
+#include <optional>
+#include <functional>
+#include <type_traits>
+#include <condition_variable>
+
+#include "taskScheduler.hpp"
+
+// everything a future and the task fulfilling it share, independent of the result type
+class FutureStateBase
+{
+	mutable std::mutex						mutex;
+	std::condition_variable					readyEvent;
+	bool									ready = false;
+	// run by the thread that makes the state ready, or right away if it already is
+	std::vector<std::function<void()>>		continuations;
+
+public:
+	// continuations are submitted with the priority of the task they follow
+	enu_TASK_PRIORITY priority = enu_TASK_PRIORITY::frame;
+	// set instead of the result when the function threw, rethrown by the handles
+	std::exception_ptr exception;
+
+	bool isReady() const
+	{
+		std::unique_lock<std::mutex> lock( mutex );
+		return ready;
+	}
+
+	void addContinuation( std::function<void()> fn )
+	{
+		{
+			std::unique_lock<std::mutex> lock( mutex );
+			if ( !ready )
+			{
+				continuations.push_back( std::move( fn ) );
+				return;
+			}
+		}
+
+		fn();
+	}
+
+	// the result or the exception has to be stored before this is called
+	void markReady()
+	{
+		std::vector<std::function<void()>> pending;
+		{
+			std::unique_lock<std::mutex> lock( mutex );
+			ready = true;
+			pending.swap( continuations );
+		}
+		readyEvent.notify_all();
+
+		for ( auto& fn : pending )
+		{
+			fn();
+		}
+	}
+
+	// runs queued frame work on the calling thread until the state is ready
+	void wait()
+	{
+		TaskScheduler* ts = TaskScheduler::instance();
+
+		while ( !isReady() )
+		{
+			if ( ts->runPendingTask() )
+			{
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock( mutex );
+			readyEvent.wait( lock, [&]() { return ready; } );
+		}
+	}
+
+	virtual ~FutureStateBase() = default;
+};
+
+template <typename T> class FutureState : public FutureStateBase
+{
+public:
+	std::optional<T> value;
+};
+
+template <> class FutureState<void> : public FutureStateBase
+{
+};
+
+// a single partition task owned by the scheduler, stores fn's result in the state
+template <typename T, typename Fn> class FutureTask : public RangedTask
+{
+	Fn								fn;
+	std::shared_ptr<FutureState<T>>	state;
+public:
+	FutureTask( Fn&& fn, std::shared_ptr<FutureState<T>> state )
+		: fn( std::move( fn ) ), state( std::move( state ) )
+	{
+		rangeSize = 1;
+		priority = this->state->priority;
+		deleteWhenDone = true;
+		name = "future";
+	}
+
+	void execute( const TaskRange& range ) override
+	{
+		// an exception must not end the worker, the future is ready either way and rethrows it
+		try
+		{
+			if constexpr ( std::is_void_v<T> )
+			{
+				fn();
+			}
+			else
+			{
+				state->value.emplace( fn() );
+			}
+		}
+		catch ( ... )
+		{
+			state->exception = std::current_exception();
+		}
+
+		state->markReady();
+	}
+};
+
+template <typename T> class Task;
+template <typename T> class TaskFuture;
+
+template <typename T> TaskFuture<T> spawn( Task<T> task );
+
+template <typename Fn> TaskFuture<std::invoke_result_t<std::decay_t<Fn>>> submit( Fn&& fn,
+	const enu_TASK_PRIORITY priority = enu_TASK_PRIORITY::frame );
+
+/*
+	TaskFuture - handle to the result of a function running on the
+	TaskScheduler, returned by submit().
+
+	The result lives in a state shared by the handles and the task, so
+	neither the caller nor the workers have to keep anything alive.
+	then() chains a function that runs as a new task once the result is
+	there, so a pipeline like read -> decode -> upload never blocks a
+	worker. get() and wait() block the caller, they run queued frame work
+	in the meantime.
+
+	An exception thrown by the function is stored in the state, get() and
+	wait() rethrow it and so do the futures of the functions chained after
+	it. whenAll() counts a failed future as done.
+
+	Tasks still queued when the scheduler shuts down are dropped and their
+	futures never become ready.
+*/
+template <typename T> class TaskFuture
+{
+	template <typename> friend class TaskFuture;
+	template <typename Fn> friend TaskFuture<std::invoke_result_t<std::decay_t<Fn>>> submit( Fn&& fn,
+		const enu_TASK_PRIORITY priority );
+	template <typename... Ts> friend TaskFuture<void> whenAll( const TaskFuture<Ts>&... futures );
+	template <typename U> friend TaskFuture<void> whenAll( const std::vector<TaskFuture<U>>& futures );
+	template <typename U> friend TaskFuture<U> spawn( Task<U> task );
+
+	std::shared_ptr<FutureState<T>> state;
+
+	explicit TaskFuture( std::shared_ptr<FutureState<T>> state ) : state( std::move( state ) ) {}
+public:
+	TaskFuture() = default;
+
+	// false for default constructed handles
+	bool valid() const
+	{
+		return state != nullptr;
+	}
+
+	bool isReady() const
+	{
+		assert( valid() && "TaskFuture: isReady() on a default constructed future." );
+		return state->isReady();
+	}
+
+	// rethrows what the function threw
+	void wait() const
+	{
+		assert( valid() && "TaskFuture: wait() on a default constructed future." );
+		state->wait();
+
+		if ( state->exception )
+		{
+			std::rethrow_exception( state->exception );
+		}
+	}
+
+	// waits for the result, the reference lives as long as any handle to it
+	template <typename U = T> std::enable_if_t<!std::is_void_v<U>, const U&> get() const
+	{
+		wait();
+		return *state->value;
+	}
+
+	// runs fn on the thread that completes the future, or right away if it is done already
+	void onReady( std::function<void()> fn ) const
+	{
+		assert( valid() && "TaskFuture: onReady() on a default constructed future." );
+		state->addContinuation( std::move( fn ) );
+	}
+
+	/*
+		runs fn( result ) (fn() for TaskFuture<void>) on the workers once the
+		result is ready, with the priority of this future's task. returns the
+		future of fn's result, or of the exception this future failed with.
+	*/
+	template <typename Fn> auto then( Fn&& fn ) const
+	{
+		assert( valid() && "TaskFuture: then() on a default constructed future." );
+		std::shared_ptr<FutureState<T>> parent = state;
+
+		auto next = [parent, fn = std::forward<Fn>( fn )]() mutable
+		{
+			// fn is skipped, its future fails with the parent's exception
+			if ( parent->exception )
+			{
+				std::rethrow_exception( parent->exception );
+			}
+
+			if constexpr ( std::is_void_v<T> )
+			{
+				return fn();
+			}
+			else
+			{
+				return fn( std::as_const( *parent->value ) );
+			}
+		};
+
+		using Result_t = std::invoke_result_t<decltype( next )&>;
+
+		std::shared_ptr<FutureState<Result_t>> nextState = std::make_shared<FutureState<Result_t>>();
+		nextState->priority = state->priority;
+
+		state->addContinuation( [nextState, next = std::move( next )]() mutable
+		{
+			TaskScheduler::instance()->execute(
+				new FutureTask<Result_t, decltype( next )>( std::move( next ), nextState ) );
+		} );
+
+		return TaskFuture<Result_t>( nextState );
+	}
+};
+
+// runs fn() on the TaskScheduler's workers, the returned future holds its result
+template <typename Fn> TaskFuture<std::invoke_result_t<std::decay_t<Fn>>> submit( Fn&& fn,
+	const enu_TASK_PRIORITY priority )
+{
+	using Result_t = std::invoke_result_t<std::decay_t<Fn>>;
+	using Fn_t = std::decay_t<Fn>;
+
+	std::shared_ptr<FutureState<Result_t>> state = std::make_shared<FutureState<Result_t>>();
+	state->priority = priority;
+
+	TaskScheduler::instance()->execute(
+		new FutureTask<Result_t, Fn_t>( Fn_t( std::forward<Fn>( fn ) ), state ) );
+
+	return TaskFuture<Result_t>( state );
+}
+
+// ready once every one of the futures is, the results stay in the futures
+template <typename... Ts> TaskFuture<void> whenAll( const TaskFuture<Ts>&... futures )
+{
+	std::shared_ptr<FutureState<void>> state = std::make_shared<FutureState<void>>();
+	if constexpr ( sizeof...( Ts ) == 0 )
+	{
+		state->markReady();
+	}
+	else
+	{
+		std::shared_ptr<std::atomic<size_t>> left = std::make_shared<std::atomic<size_t>>( sizeof...( Ts ) );
+		auto arrive = [state, left]()
+		{
+			if ( left->fetch_sub( 1 ) == 1 )
+			{
+				state->markReady();
+			}
+		};
+
+		( futures.state->addContinuation( arrive ), ... );
+	}
+
+	return TaskFuture<void>( state );
+}
+
+template <typename T> TaskFuture<void> whenAll( const std::vector<TaskFuture<T>>& futures )
+{
+	std::shared_ptr<FutureState<void>> state = std::make_shared<FutureState<void>>();
+	if ( futures.empty() )
+	{
+		state->markReady();
+		return TaskFuture<void>( state );
+	}
+
+	std::shared_ptr<std::atomic<size_t>> left = std::make_shared<std::atomic<size_t>>( futures.size() );
+	for ( const TaskFuture<T>& it : futures )
+	{
+		it.state->addContinuation( [state, left]()
+		{
+			if ( left->fetch_sub( 1 ) == 1 )
+			{
+				state->markReady();
+			}
+		} );
+	}
+
+	return TaskFuture<void>( state );
+}
\ No newline at end of file
@@ -0,0 +1,247 @@
+#include "taskGraph.hpp"
+#include <cassert>
+#include <algorithm>
+
+void TaskNodeTask::execute( const TaskRange& range )
+{
+	graph->runNode( node );
+}
+
+TaskGraph::NodeId TaskGraph::add( const std::string& name, std::function<void()> work,
+	std::initializer_list<NodeId> dependencies )
+{
+	std::unique_ptr<TaskNode> node = std::make_unique<TaskNode>();
+	node->name = name;
+	node->work = std::move( work );
+	node->task.graph = this;
+	node->task.node = nodes.size();
+	node->task.rangeSize = 1;
+	node->task.name = node->name.c_str();
+
+	nodes.push_back( std::move( node ) );
+
+	for ( const NodeId dependency : dependencies )
+	{
+		addDependency( nodes.size() - 1, dependency );
+	}
+
+	compiled = false;
+	return nodes.size() - 1;
+}
+
+void TaskGraph::addDependency( const NodeId node, const NodeId dependency )
+{
+	assert( node < nodes.size() && dependency < nodes.size() && node != dependency );
+
+	edges.push_back( { dependency, node } );
+	compiled = false;
+}
+
+bool TaskGraph::conflicts( const TaskNode& a, const TaskNode& b ) const
+{
+	auto overlaps = []( const std::vector<size_t>& x, const std::vector<size_t>& y )
+	{
+		for ( const size_t id : x )
+		{
+			if ( std::find( y.begin(), y.end(), id ) != y.end() )
+			{
+				return true;
+			}
+		}
+
+		return false;
+	};
+
+	// readers can share, a writer excludes everyone else
+	return overlaps( a.writes, b.writes ) || overlaps( a.writes, b.reads ) || overlaps( a.reads, b.writes );
+}
+
+void TaskGraph::compile()
+{
+	for ( auto& it : nodes )
+	{
+		it->dependents.clear();
+		it->dependencyCount = 0;
+	}
+
+	auto link = [&]( const size_t from, const size_t to )
+	{
+		std::vector<size_t>& dependents = nodes[from]->dependents;
+		if ( std::find( dependents.begin(), dependents.end(), to ) == dependents.end() )
+		{
+			dependents.push_back( to );
+			nodes[to]->dependencyCount++;
+		}
+	};
+
+	for ( const auto& edge : edges )
+	{
+		link( edge.first, edge.second );
+	}
+
+	// conflicting access is ordered by insertion
+	for ( size_t i = 0; i < nodes.size(); i++ )
+	{
+		for ( size_t j = i + 1; j < nodes.size(); j++ )
+		{
+			if ( conflicts( *nodes[i], *nodes[j] ) )
+			{
+				link( i, j );
+			}
+		}
+	}
+
+#ifndef NDEBUG
+	// every node has to be reachable from a root, otherwise there is a cycle
+	std::vector<size_t> counts( nodes.size() );
+	std::vector<size_t> ready;
+	for ( size_t i = 0; i < nodes.size(); i++ )
+	{
+		counts[i] = nodes[i]->dependencyCount;
+		if ( counts[i] == 0 )
+		{
+			ready.push_back( i );
+		}
+	}
+
+	size_t visited = 0;
+	while ( !ready.empty() )
+	{
+		const size_t n = ready.back();
+		ready.pop_back();
+		visited++;
+
+		for ( const size_t d : nodes[n]->dependents )
+		{
+			if ( --counts[d] == 0 )
+			{
+				ready.push_back( d );
+			}
+		}
+	}
+
+	assert( visited == nodes.size() && "TaskGraph: the dependencies contain a cycle." );
+#endif
+
+	compiled = true;
+}
+
+void TaskGraph::submit( const size_t node )
+{
+	TaskScheduler::instance()->execute( &nodes[node]->task );
+}
+
+void TaskGraph::runNode( const size_t node )
+{
+	TaskNode& n = *nodes[node];
+	if ( n.work )
+	{
+		n.work();
+	}
+
+	for ( const size_t d : n.dependents )
+	{
+		if ( nodes[d]->pending.fetch_sub( 1 ) == 1 )
+		{
+			submit( d );
+		}
+	}
+
+	if ( remaining.fetch_sub( 1 ) == 1 )
+	{
+		std::unique_lock<std::mutex> lock( doneMutex );
+		doneEvent.notify_all();
+	}
+}
+
+// without workers the nodes run on the caller in dependency order
+void TaskGraph::runSerial()
+{
+	std::vector<size_t> ready;
+	for ( size_t i = 0; i < nodes.size(); i++ )
+	{
+		if ( nodes[i]->dependencyCount == 0 )
+		{
+			ready.push_back( i );
+		}
+	}
+
+	// front to back keeps independent nodes in insertion order
+	for ( size_t i = 0; i < ready.size(); i++ )
+	{
+		TaskNode& n = *nodes[ready[i]];
+		if ( n.work )
+		{
+			n.work();
+		}
+
+		for ( const size_t d : n.dependents )
+		{
+			if ( nodes[d]->pending.fetch_sub( 1 ) == 1 )
+			{
+				ready.push_back( d );
+			}
+		}
+	}
+
+	remaining = 0;
+}
+
+void TaskGraph::run()
+{
+	if ( nodes.empty() )
+	{
+		return;
+	}
+
+	if ( !compiled )
+	{
+		compile();
+	}
+
+	for ( auto& it : nodes )
+	{
+		it->pending = it->dependencyCount;
+	}
+	remaining = nodes.size();
+
+	TaskScheduler* ts = TaskScheduler::instance();
+	if ( ts->getThreadCount() == 0 )
+	{
+		runSerial();
+		return;
+	}
+
+	for ( size_t i = 0; i < nodes.size(); i++ )
+	{
+		if ( nodes[i]->dependencyCount == 0 )
+		{
+			submit( i );
+		}
+	}
+
+	while ( remaining.load() > 0 )
+	{
+		if ( ts->runPendingTask() )
+		{
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock( doneMutex );
+		doneEvent.wait( lock, [&]() { return remaining.load() == 0; } );
+	}
+
+	// the last partitions may still be finishing their bookkeeping,
+	// the node tasks must be idle before the next run reuses them
+	for ( auto& it : nodes )
+	{
+		ts->waitFor( &it->task );
+	}
+}
+
+void TaskGraph::clear()
+{
+	nodes.clear();
+	edges.clear();
+	compiled = false;
+}
\ No newline at end of file
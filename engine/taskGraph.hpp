@@ -0,0 +1,106 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <utility>
+#include <functional>
+#include <initializer_list>
+#include <condition_variable>
+
+#include "taskScheduler.hpp"
+#include "entityManager.hpp"
+
+class TaskGraph;
+
+// runs one node of the graph as a single partition task
+class TaskNodeTask : public RangedTask
+{
+public:
+	TaskGraph*	graph = nullptr;
+	size_t		node = 0;
+
+	void execute( const TaskRange& range ) override;
+};
+
+struct TaskNode
+{
+	std::string				name;
+	std::function<void()>	work;
+
+	// component type ids the node touches, used to order conflicting nodes
+	std::vector<size_t>		reads;
+	std::vector<size_t>		writes;
+
+	// nodes waiting for this one, filled by compile()
+	std::vector<size_t>		dependents;
+	size_t					dependencyCount = 0;
+
+	// dependencies left in the current run
+	std::atomic<size_t>		pending{ 0 };
+	TaskNodeTask			task;
+};
+
+/*
+	TaskGraph - a set of jobs with dependencies between them, run on the
+	TaskScheduler's workers.
+
+	A node starts as soon as everything it depends on is done, nodes that
+	don't depend on each other run at the same time. Besides explicit
+	dependencies, nodes can list the component types they read and write:
+	two nodes where one writes what the other touches run in the order
+	they were added.
+
+	run() is called from one thread at a time and returns when every
+	node is done. The calling thread runs queued work while it waits.
+*/
+class TaskGraph
+{
+	friend class TaskNodeTask;
+
+	std::vector<std::unique_ptr<TaskNode>>	nodes;
+	std::vector<std::pair<size_t, size_t>>	edges;
+	bool									compiled = false;
+
+	std::atomic<size_t>						remaining{ 0 };
+	std::mutex								doneMutex;
+	std::condition_variable					doneEvent;
+
+	bool conflicts( const TaskNode& a, const TaskNode& b ) const;
+	void compile();
+
+	void submit( const size_t node );
+	void runNode( const size_t node );
+	void runSerial();
+public:
+	using NodeId = size_t;
+
+	NodeId add( const std::string& name, std::function<void()> work,
+		std::initializer_list<NodeId> dependencies = {} );
+	void addDependency( const NodeId node, const NodeId dependency );
+
+	template <typename... Ts> void reads( const NodeId node )
+	{
+		( nodes[node]->reads.push_back( ComponentTypeId::get<Ts>() ), ... );
+		compiled = false;
+	}
+	template <typename... Ts> void writes( const NodeId node )
+	{
+		( nodes[node]->writes.push_back( ComponentTypeId::get<Ts>() ), ... );
+		compiled = false;
+	}
+
+	const TaskNode& getNode( const NodeId node ) const
+	{
+		return *nodes[node];
+	}
+	size_t size() const
+	{
+		return nodes.size();
+	}
+
+	void run();
+	void clear();
+};
\ No newline at end of file
@@ -0,0 +1,191 @@
+#include "taskProfiler.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+
+void TaskProfiler::reset( const size_t workerCount )
+{
+	threads.clear();
+	for ( size_t i = 0; i < workerCount + 1; i++ )
+	{
+		threads.push_back( std::make_unique<ThreadData>() );
+		threads.back()->timeline.resize( TimelineEventsPerThread );
+	}
+}
+
+void TaskProfiler::clear()
+{
+	for ( auto& it : threads )
+	{
+		it->tasksExecuted = 0;
+		it->wakeups = 0;
+		it->stealAttempts = 0;
+		it->steals = 0;
+		it->busyNs = 0;
+		it->idleNs = 0;
+		it->queueHighWater = it->queueDepth.load();
+
+		std::lock_guard<std::mutex> lock( it->timelineMutex );
+		it->timelineNext = 0;
+		it->timelineCount = 0;
+	}
+}
+
+void TaskProfiler::taskRun( const size_t thread, const char* name, const size_t rangeStart,
+	const size_t rangeEnd, const uint64_t begin, const uint64_t end )
+{
+	ThreadData& data = *threads[thread];
+	data.tasksExecuted.fetch_add( 1, std::memory_order_relaxed );
+	data.busyNs.fetch_add( end - begin, std::memory_order_relaxed );
+
+	std::lock_guard<std::mutex> lock( data.timelineMutex );
+	TaskTimelineEvent& e = data.timeline[data.timelineNext];
+
+	std::snprintf( e.name, sizeof( e.name ), "%s", name );
+	e.thread = (uint32_t)thread;
+	e.begin = begin;
+	e.end = end;
+	e.rangeStart = rangeStart;
+	e.rangeEnd = rangeEnd;
+
+	data.timelineNext = ( data.timelineNext + 1 ) % data.timeline.size();
+	data.timelineCount = std::min( data.timelineCount + 1, data.timeline.size() );
+}
+
+void TaskProfiler::idle( const size_t thread, const uint64_t begin, const uint64_t end )
+{
+	ThreadData& data = *threads[thread];
+	data.wakeups.fetch_add( 1, std::memory_order_relaxed );
+	data.idleNs.fetch_add( end - begin, std::memory_order_relaxed );
+}
+
+void TaskProfiler::stealAttempt( const size_t thread, const bool success )
+{
+	ThreadData& data = *threads[thread];
+	data.stealAttempts.fetch_add( 1, std::memory_order_relaxed );
+	if ( success )
+	{
+		data.steals.fetch_add( 1, std::memory_order_relaxed );
+	}
+}
+
+void TaskProfiler::queuePushed( const size_t thread )
+{
+	if ( !isEnabled() )
+	{
+		return;
+	}
+
+	ThreadData& data = *threads[thread];
+	const int64_t depth = data.queueDepth.fetch_add( 1, std::memory_order_relaxed ) + 1;
+
+	int64_t highWater = data.queueHighWater.load( std::memory_order_relaxed );
+	while ( depth > highWater && !data.queueHighWater.compare_exchange_weak( highWater, depth ) )
+	{
+	}
+}
+
+void TaskProfiler::queuePopped( const size_t thread )
+{
+	if ( !isEnabled() )
+	{
+		return;
+	}
+
+	// a partition queued before the profiler was turned on wasn't counted, the depth stays at 0
+	std::atomic<int64_t>& depth = threads[thread]->queueDepth;
+	int64_t current = depth.load( std::memory_order_relaxed );
+	while ( current > 0 && !depth.compare_exchange_weak( current, current - 1, std::memory_order_relaxed ) )
+	{
+	}
+}
+
+std::vector<TaskWorkerStats> TaskProfiler::getStats() const
+{
+	std::vector<TaskWorkerStats> stats;
+	for ( const auto& it : threads )
+	{
+		TaskWorkerStats s;
+		s.tasksExecuted = it->tasksExecuted.load();
+		s.wakeups = it->wakeups.load();
+		s.stealAttempts = it->stealAttempts.load();
+		s.steals = it->steals.load();
+		s.queueHighWater = (size_t)std::max<int64_t>( it->queueHighWater.load(), 0 );
+		s.busyMs = it->busyNs.load() / 1'000'000.0;
+		s.idleMs = it->idleNs.load() / 1'000'000.0;
+
+		stats.push_back( s );
+	}
+
+	return stats;
+}
+
+std::vector<TaskTimelineEvent> TaskProfiler::getTimeline() const
+{
+	std::vector<TaskTimelineEvent> events;
+	for ( const auto& it : threads )
+	{
+		std::lock_guard<std::mutex> lock( it->timelineMutex );
+
+		const size_t size = it->timeline.size();
+		const size_t first = ( it->timelineNext + size - it->timelineCount ) % size;
+		for ( size_t i = 0; i < it->timelineCount; i++ )
+		{
+			events.push_back( it->timeline[( first + i ) % size] );
+		}
+	}
+
+	std::sort( events.begin(), events.end(), []( const TaskTimelineEvent& a, const TaskTimelineEvent& b )
+	{
+		return a.begin < b.begin;
+	} );
+
+	return events;
+}
+
+std::string TaskProfiler::toChromeTrace() const
+{
+	std::string json = "{\"traceEvents\":[";
+	char buffer[256];
+
+	// names the rows of the trace viewer
+	for ( size_t i = 0; i < threads.size(); i++ )
+	{
+		std::snprintf( buffer, sizeof( buffer ),
+			"%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%zu,\"args\":{\"name\":\"%s %zu\"}}",
+			i == 0 ? "" : ",", i, i + 1 == threads.size() ? "other" : "worker", i );
+		json += buffer;
+	}
+
+	for ( const TaskTimelineEvent& e : getTimeline() )
+	{
+		// the names come from type names and node names, keep quotes and backslashes out of the json
+		std::string name = e.name;
+		std::replace_if( name.begin(), name.end(), []( const char c )
+		{
+			return c == '"' || c == '\\' || c < ' ';
+		}, '_' );
+
+		std::snprintf( buffer, sizeof( buffer ),
+			",{\"name\":\"%s\",\"cat\":\"task\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,"
+			"\"args\":{\"range\":\"%zu-%zu\"}}",
+			name.c_str(), e.thread, e.begin / 1'000.0, ( e.end - e.begin ) / 1'000.0, e.rangeStart, e.rangeEnd );
+		json += buffer;
+	}
+
+	json += "],\"displayTimeUnit\":\"ms\"}";
+	return json;
+}
+
+bool TaskProfiler::exportChromeTrace( const std::string& path ) const
+{
+	std::ofstream file( path, std::ios::binary );
+	if ( !file.good() )
+	{
+		return false;
+	}
+
+	file << toChromeTrace();
+	return file.good();
+}
\ No newline at end of file
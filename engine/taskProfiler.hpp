@@ -0,0 +1,130 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// counters of one scheduler thread, see TaskProfiler::getStats()
+struct TaskWorkerStats
+{
+	// partitions run on the thread
+	size_t		tasksExecuted	= 0;
+	// times the thread woke up from waiting for work
+	size_t		wakeups			= 0;
+	size_t		stealAttempts	= 0;
+	size_t		steals			= 0;
+	// most partitions waiting in the thread's queues at once
+	size_t		queueHighWater	= 0;
+	double		busyMs			= 0.0;
+	double		idleMs			= 0.0;
+};
+
+// one partition run, times are nanoseconds since the profiler was created
+struct TaskTimelineEvent
+{
+	char		name[32];
+	uint32_t	thread;
+	uint64_t	begin;
+	uint64_t	end;
+	size_t		rangeStart;
+	size_t		rangeEnd;
+};
+
+/*
+	TaskProfiler - optional instrumentation of the TaskScheduler.
+
+	Every worker has its own slot of counters and a ring buffer holding
+	its latest partition runs, the last slot is shared by every other
+	thread that runs partitions (waitFor, runPendingTask, the caller of
+	execute() without workers).
+
+	Disabled it costs a few relaxed loads per partition, so it can stay in
+	shipping builds and be turned on when something looks wrong. The
+	timeline exports as Chrome trace JSON (chrome://tracing, Perfetto).
+*/
+class TaskProfiler
+{
+	struct alignas( 64 ) ThreadData
+	{
+		std::atomic<size_t>		tasksExecuted{ 0 };
+		std::atomic<size_t>		wakeups{ 0 };
+		std::atomic<size_t>		stealAttempts{ 0 };
+		std::atomic<size_t>		steals{ 0 };
+		std::atomic<uint64_t>	busyNs{ 0 };
+		std::atomic<uint64_t>	idleNs{ 0 };
+
+		// tracked while enabled only, partitions queued before that don't count
+		std::atomic<int64_t>	queueDepth{ 0 };
+		std::atomic<int64_t>	queueHighWater{ 0 };
+
+		// ring buffer, written by the owner thread and read by the exporters
+		mutable std::mutex				timelineMutex;
+		std::vector<TaskTimelineEvent>	timeline;
+		size_t							timelineNext = 0;
+		size_t							timelineCount = 0;
+	};
+
+	std::vector<std::unique_ptr<ThreadData>>	threads;
+	std::atomic<bool>							enabled{ false };
+	std::chrono::steady_clock::time_point		epoch = std::chrono::steady_clock::now();
+public:
+	static constexpr size_t TimelineEventsPerThread = 4096;
+
+	TaskProfiler()
+	{
+		reset( 0 );
+	}
+
+	// slots for the workers plus one for every other thread, clears everything
+	void reset( const size_t workerCount );
+	// zeroes the counters and the timelines, keeps the slots
+	void clear();
+
+	// the queue depths start over from empty every time it is turned on
+	void setEnabled( const bool enable )
+	{
+		if ( enable && !isEnabled() )
+		{
+			for ( auto& it : threads )
+			{
+				it->queueDepth = 0;
+			}
+		}
+
+		enabled = enable;
+	}
+	bool isEnabled() const
+	{
+		return enabled.load( std::memory_order_relaxed );
+	}
+
+	uint64_t now() const
+	{
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - epoch ).count();
+	}
+
+	size_t threadCount() const
+	{
+		return threads.size();
+	}
+
+	// hooks for the scheduler, thread is the worker index or threadCount() - 1
+	void taskRun( const size_t thread, const char* name, const size_t rangeStart, const size_t rangeEnd,
+		const uint64_t begin, const uint64_t end );
+	void idle( const size_t thread, const uint64_t begin, const uint64_t end );
+	void stealAttempt( const size_t thread, const bool success );
+	void queuePushed( const size_t thread );
+	void queuePopped( const size_t thread );
+
+	std::vector<TaskWorkerStats> getStats() const;
+	// every buffered event of every thread, oldest first
+	std::vector<TaskTimelineEvent> getTimeline() const;
+
+	std::string toChromeTrace() const;
+	bool exportChromeTrace( const std::string& path ) const;
+};
\ No newline at end of file
@@ -1,4 +1,13 @@
 #include "taskScheduler.hpp"
+#include <typeinfo>
+#include <algorithm>
+
+#if defined( _WIN32 )
+#include <Windows.h>
+#elif defined( __linux__ )
+#include <sched.h>
+#include <pthread.h>
+#endif
 
 std::unique_ptr<TaskScheduler> TaskScheduler::_instance = std::make_unique<TaskScheduler>();
 
@@ -7,57 +16,326 @@ TaskScheduler* TaskScheduler::instance()
 	return _instance.get();
 }
 
+// cpus the process is allowed to run on, respects taskset/job object restrictions
+static std::vector<size_t> AvailableCpus()
+{
+	std::vector<size_t> cpus;
+
+#if defined( _WIN32 )
+	DWORD_PTR processMask, systemMask;
+	if ( GetProcessAffinityMask( GetCurrentProcess(), &processMask, &systemMask ) )
+	{
+		for ( size_t i = 0; i < sizeof( DWORD_PTR ) * 8; i++ )
+		{
+			if ( processMask & ( (DWORD_PTR)1 << i ) )
+			{
+				cpus.push_back( i );
+			}
+		}
+	}
+#elif defined( __linux__ )
+	cpu_set_t set;
+	CPU_ZERO( &set );
+	if ( sched_getaffinity( 0, sizeof( set ), &set ) == 0 )
+	{
+		for ( size_t i = 0; i < CPU_SETSIZE; i++ )
+		{
+			if ( CPU_ISSET( i, &set ) )
+			{
+				cpus.push_back( i );
+			}
+		}
+	}
+#endif
+
+	if ( cpus.empty() )
+	{
+		for ( size_t i = 0; i < std::max<size_t>( std::thread::hardware_concurrency(), 1 ); i++ )
+		{
+			cpus.push_back( i );
+		}
+	}
+
+	return cpus;
+}
+
+static bool PinThread( std::thread& thread, const size_t cpu )
+{
+#if defined( _WIN32 )
+	return SetThreadAffinityMask( (HANDLE)thread.native_handle(), (DWORD_PTR)1 << cpu ) != 0;
+#elif defined( __linux__ )
+	cpu_set_t set;
+	CPU_ZERO( &set );
+	CPU_SET( cpu, &set );
+	return pthread_setaffinity_np( thread.native_handle(), sizeof( set ), &set ) == 0;
+#else
+	return false;
+#endif
+}
+
+// binds the calling thread to cpu, previous gets the cpus it was allowed to run on before
+static bool PinCurrentThread( const size_t cpu, std::vector<size_t>& previous )
+{
+	previous.clear();
+
+#if defined( _WIN32 )
+	const DWORD_PTR mask = SetThreadAffinityMask( GetCurrentThread(), (DWORD_PTR)1 << cpu );
+	for ( size_t i = 0; i < sizeof( DWORD_PTR ) * 8; i++ )
+	{
+		if ( mask & ( (DWORD_PTR)1 << i ) )
+		{
+			previous.push_back( i );
+		}
+	}
+#elif defined( __linux__ )
+	cpu_set_t set;
+	CPU_ZERO( &set );
+	if ( pthread_getaffinity_np( pthread_self(), sizeof( set ), &set ) != 0 )
+	{
+		return false;
+	}
+
+	for ( size_t i = 0; i < CPU_SETSIZE; i++ )
+	{
+		if ( CPU_ISSET( i, &set ) )
+		{
+			previous.push_back( i );
+		}
+	}
+
+	CPU_ZERO( &set );
+	CPU_SET( cpu, &set );
+	if ( pthread_setaffinity_np( pthread_self(), sizeof( set ), &set ) != 0 )
+	{
+		previous.clear();
+	}
+#endif
+
+	return !previous.empty();
+}
+
+// lets the calling thread run on the cpus again
+static void UnpinCurrentThread( const std::vector<size_t>& cpus )
+{
+#if defined( _WIN32 )
+	DWORD_PTR mask = 0;
+	for ( const size_t cpu : cpus )
+	{
+		mask |= (DWORD_PTR)1 << cpu;
+	}
+	SetThreadAffinityMask( GetCurrentThread(), mask );
+#elif defined( __linux__ )
+	cpu_set_t set;
+	CPU_ZERO( &set );
+	for ( const size_t cpu : cpus )
+	{
+		CPU_SET( cpu, &set );
+	}
+	pthread_setaffinity_np( pthread_self(), sizeof( set ), &set );
+#endif
+}
+
+size_t TaskScheduler::getAvailableCpuCount()
+{
+	return AvailableCpus().size();
+}
+
 bool RangedTask::isComplete() const
 {
 	return rangesLeftToProcess.load() == 0;
 }
 
-std::vector<PartitionedTaskSet> TaskScheduler::divideTask( RangedTask* task )
+size_t TaskScheduler::grainOf( const RangedTask* task ) const
 {
-	std::vector<PartitionedTaskSet> res;
+	size_t grain = task->grainSize;
+	if ( grain == 0 )
+	{
+		const size_t partitions = std::max<size_t>( numThreads, 1 ) * AutoPartitionsPerThread;
+		grain = ( task->rangeSize + partitions - 1 ) / partitions;
+	}
 
-	const size_t range = task->rangeSize;
-	const size_t partitionSize = range / numThreads;
+	return std::max<size_t>( grain, 1 );
+}
 
-	PartitionedTaskSet pts;
-	pts.task = task;
+void TaskScheduler::runPartition( const PartitionedTaskSet& pTask, const size_t thread )
+{
+	// read up front, a task that isn't ours may be gone once the counter drops
+	const bool deleteWhenDone = pTask.task->deleteWhenDone;
 
-	TaskRange tr;
-	for( size_t i = 0; i < numThreads; i++ )
+	if( profiler.isEnabled() )
+	{
+		const char* name = pTask.task->name ? pTask.task->name : typeid( *pTask.task ).name();
+		const uint64_t begin = profiler.now();
+
+		pTask.task->execute( pTask.range );
+
+		// every thread that isn't a worker shares the last slot
+		const size_t slot = thread < numThreads ? thread : profiler.threadCount() - 1;
+		profiler.taskRun( slot, name, pTask.range.start, pTask.range.end, begin, profiler.now() );
+	}
+	else
 	{
-		tr.start = i * partitionSize;
+		pTask.task->execute( pTask.range );
+	}
 
-		if( i != numThreads - 1 )
+	// the task may be destroyed by its waiter as soon as the counter hits zero, don't touch it after
+	if( pTask.task->rangesLeftToProcess.fetch_sub( 1 ) == 1 )
+	{
+		if( deleteWhenDone )
 		{
-			tr.end = ( i + 1 ) * partitionSize;
+			delete pTask.task;
 		}
-		else
+
+		std::unique_lock<std::mutex> lock( completionMutex );
+		completionEvent.notify_all();
+	}
+}
+
+bool TaskScheduler::push( const enu_TASK_PRIORITY priority, const size_t queueIndex, const PartitionedTaskSet& pTask )
+{
+	const size_t p = (size_t)priority;
+
+	// counted before the push so a sleeping worker never misses a queued partition
+	const size_t queued = ++queuedPartitions[p];
+
+	// background partitions ignore the limit, running them on the caller would stall it
+	const bool limited = priority == enu_TASK_PRIORITY::frame && queueLimit != 0 && queued > queueLimit;
+	profiler.queuePushed( queueIndex );
+	if( limited || !taskQueues[p][queueIndex]->push( pTask ) )
+	{
+		profiler.queuePopped( queueIndex );
+		--queuedPartitions[p];
+		return false;
+	}
+
+	const size_t total = queuedPartitions[0].load() + queuedPartitions[1].load();
+	size_t highWater = queuedHighWater.load();
+	while( total > highWater && !queuedHighWater.compare_exchange_weak( highWater, total ) )
+	{
+	}
+
+	return true;
+}
+
+bool TaskScheduler::pop( const enu_TASK_PRIORITY priority, const size_t queueIndex, PartitionedTaskSet& pTask )
+{
+	const size_t p = (size_t)priority;
+
+	if( taskQueues[p][queueIndex]->pop( pTask ) )
+	{
+		profiler.queuePopped( queueIndex );
+		--queuedPartitions[p];
+		return true;
+	}
+
+	return false;
+}
+
+bool TaskScheduler::steal( const enu_TASK_PRIORITY priority, const size_t thiefIndex, PartitionedTaskSet& pTask )
+{
+	// start next to the thief so the victims are spread out
+	bool stolen = false;
+	for( size_t i = 1; i < numThreads && !stolen; i++ )
+	{
+		stolen = pop( priority, ( thiefIndex + i ) % numThreads, pTask );
+	}
+
+	if( profiler.isEnabled() && numThreads > 1 )
+	{
+		profiler.stealAttempt( thiefIndex, stolen );
+	}
+
+	return stolen;
+}
+
+bool TaskScheduler::popAny( PartitionedTaskSet& pTask )
+{
+	for( size_t i = 0; i < numThreads; i++ )
+	{
+		if( pop( enu_TASK_PRIORITY::frame, i, pTask ) )
 		{
-			tr.end = range;
+			return true;
 		}
+	}
+
+	return false;
+}
 
-		pts.range = tr;
-		res.push_back( pts );
+bool TaskScheduler::acquireBackgroundSlot()
+{
+	size_t running = runningBackground.load();
+	while( running < backgroundSlots )
+	{
+		if( runningBackground.compare_exchange_weak( running, running + 1 ) )
+		{
+			return true;
+		}
 	}
 
-	return res;
-};
+	return false;
+}
+
+void TaskScheduler::releaseBackgroundSlot()
+{
+	--runningBackground;
+
+	// a worker may have gone to sleep because the slots were taken
+	if( queuedPartitions[(size_t)enu_TASK_PRIORITY::background].load() > 0 )
+	{
+		std::unique_lock<std::mutex> lock( convarMutex );
+		threadEvent.notify_one();
+	}
+}
+
+bool TaskScheduler::hasQueuedWork() const
+{
+	return queuedPartitions[(size_t)enu_TASK_PRIORITY::frame].load() > 0 || 
+		( queuedPartitions[(size_t)enu_TASK_PRIORITY::background].load() > 0 && 
+		  runningBackground.load() < backgroundSlots );
+}
 
 void TaskScheduler::threadFn( const size_t queueIndex )
 {
+	PartitionedTaskSet pTask;
+
 	while( !isShuttingDown )
 	{
+		if( pop( enu_TASK_PRIORITY::frame, queueIndex, pTask ) || steal( enu_TASK_PRIORITY::frame, queueIndex, pTask ) )
 		{
-			std::unique_lock<std::mutex> lock( convarMutex );
-			threadEvent.wait( lock );
+			runPartition( pTask, queueIndex );
+			continue;
 		}
 
-		if( !taskQueues[queueIndex].empty() )
+		// one background partition at a time, the frame queues are checked again after it
+		if( acquireBackgroundSlot() )
 		{
-			PartitionedTaskSet pTask;
-			taskQueues[queueIndex].pop( pTask );
-			pTask.task->execute( pTask.range );
-			pTask.task->rangesLeftToProcess.fetch_sub( 1 );
+			const bool found = pop( enu_TASK_PRIORITY::background, queueIndex, pTask ) || 
+				steal( enu_TASK_PRIORITY::background, queueIndex, pTask );
+			if( found )
+			{
+				runPartition( pTask, queueIndex );
+			}
+
+			releaseBackgroundSlot();
+			if( found )
+			{
+				continue;
+			}
+		}
+
+		// check the queues before sleeping, a notify sent while this 
+		// thread was busy would be lost otherwise
+		const bool profiling = profiler.isEnabled();
+		const uint64_t idleBegin = profiling ? profiler.now() : 0;
+
+		std::unique_lock<std::mutex> lock( convarMutex );
+		threadEvent.wait( lock, [&]() { 
+			return isShuttingDown || hasQueuedWork(); 
+		} );
+
+		if( profiling )
+		{
+			profiler.idle( queueIndex, idleBegin, profiler.now() );
 		}
 	}
 
@@ -66,10 +344,28 @@ void TaskScheduler::threadFn( const size_t queueIndex )
 
 void TaskScheduler::initialize( const size_t nThreads )
 {
+	// allows restarting with a different thread count after shutdown()
+	isShuttingDown = false;
+	threads.clear();
+
 	numThreads = nThreads;
 	runningThreads = 0;
+	runningBackground = 0;
+	pinnedThreads = 0;
+	profiler.reset( nThreads );
+	// one worker always stays free for frame work, unless there is only one
+	backgroundSlots = std::max<size_t>( nThreads, 2 ) - 1;
+
+	// the preallocated nodes cover a typical frame, more are allocated on demand
+	for( size_t p = 0; p < TaskPriorityCount; p++ )
+	{
+		queuedPartitions[p] = 0;
+		for( size_t i = 0; i < nThreads; i++ )
+		{
+			taskQueues[p].push_back( std::make_unique<TaskQueue_t>( 256 ) );
+		}
+	}
 
-	taskQueues = new TaskQueue_t[nThreads];
 	for( size_t i = 0; i < nThreads; i++ )
 	{
 		threads.emplace_back( std::thread( [&, i]() { threadFn( i ); } ) );
@@ -77,6 +373,33 @@ void TaskScheduler::initialize( const size_t nThreads )
 	}
 };
 
+void TaskScheduler::initialize( const TaskSchedulerConfig& config )
+{
+	const std::vector<size_t> cpus = AvailableCpus();
+	// with a single cpu there is nothing to keep free
+	const size_t reserved = config.reserveMainThread && cpus.size() > 1 ? 1 : 0;
+
+	initialize( config.threads != 0 ? config.threads : cpus.size() - reserved );
+
+	if ( config.pinWorkers )
+	{
+		// one worker per cpu, more workers than cpus share them round robin
+		for ( size_t i = 0; i < threads.size(); i++ )
+		{
+			if ( PinThread( threads[i], cpus[reserved + i % ( cpus.size() - reserved )] ) )
+			{
+				pinnedThreads++;
+			}
+		}
+
+		// the caller is the main thread, it gets the cpu the workers leave free
+		if ( reserved == 1 )
+		{
+			PinCurrentThread( cpus[0], mainThreadCpus );
+		}
+	}
+}
+
 void TaskScheduler::shutdown()
 {
 	{
@@ -92,26 +415,184 @@ void TaskScheduler::shutdown()
 		it.join();
 	}
 
-	delete[] taskQueues;
+	// partitions nobody ran anymore, the tasks the scheduler owns are freed with them
+	PartitionedTaskSet pTask;
+	for( auto& it : taskQueues )
+	{
+		for( auto& queue : it )
+		{
+			while( queue->pop( pTask ) )
+			{
+				if( pTask.task->deleteWhenDone && pTask.task->rangesLeftToProcess.fetch_sub( 1 ) == 1 )
+				{
+					delete pTask.task;
+				}
+			}
+		}
+
+		it.clear();
+	}
+	threads.clear();
+	numThreads = 0;
+	pinnedThreads = 0;
+
+	// like initialize() this runs on the main thread
+	if ( !mainThreadCpus.empty() )
+	{
+		UnpinCurrentThread( mainThreadCpus );
+		mainThreadCpus.clear();
+	}
+
+	// nothing is going to drain it anymore
+	std::unique_lock<std::mutex> lock( mainThreadMutex );
+	mainThreadQueue.clear();
+}
+
+size_t TaskScheduler::getThreadCount() const
+{
+	return taskQueues[0].empty() ? 0 : numThreads;
+}
+
+size_t TaskScheduler::getPinnedThreadCount() const
+{
+	return pinnedThreads;
+}
+
+bool TaskScheduler::isMainThreadPinned() const
+{
+	return !mainThreadCpus.empty();
+}
+
+void TaskScheduler::setQueueLimit( const size_t limit )
+{
+	queueLimit = limit;
+}
+
+TaskQueueStats TaskScheduler::getQueueStats() const
+{
+	TaskQueueStats stats;
+	stats.queuedBackground = queuedPartitions[(size_t)enu_TASK_PRIORITY::background].load();
+	stats.queued = queuedPartitions[(size_t)enu_TASK_PRIORITY::frame].load() + stats.queuedBackground;
+	stats.queuedHighWater = queuedHighWater.load();
+	stats.ranByCaller = ranByCaller.load();
+
+	return stats;
 }
 
 void TaskScheduler::execute( RangedTask* task )
 {
-	std::vector<PartitionedTaskSet> pts = divideTask( task );
-	task->rangesLeftToProcess = (int)pts.size();
-	for( size_t i = 0; i < pts.size(); i++ )
+	const size_t range = task->rangeSize;
+	const size_t grain = grainOf( task );
+	const size_t count = ( range + grain - 1 ) / grain;
+	task->rangesLeftToProcess = (int)count;
+
+	PartitionedTaskSet pts;
+	pts.task = task;
+
+	// without workers the caller does everything
+	if( numThreads == 0 || taskQueues[0].empty() )
 	{
-		taskQueues[i % numThreads].push( pts[i] );
+		for( size_t i = 0; i < count; i++ )
+		{
+			pts.range.start = i * grain;
+			pts.range.end = std::min( pts.range.start + grain, range );
+			runPartition( pts, numThreads );
+		}
+
+		return;
 	}
 
-	std::unique_lock<std::mutex> lock( convarMutex );
-	threadEvent.notify_all();
+	// neighbouring partitions go to the same queue so a worker walks a contiguous range.
+	// partitions are cut on the fly, only the rare overflow allocates
+	const size_t first = nextQueue.fetch_add( 1 );
+	std::vector<PartitionedTaskSet> overflow;
+	for( size_t i = 0; i < count; i++ )
+	{
+		pts.range.start = i * grain;
+		pts.range.end = std::min( pts.range.start + grain, range );
+
+		const size_t queue = ( first + i * numThreads / count ) % numThreads;
+		if( !push( task->priority, queue, pts ) )
+		{
+			overflow.push_back( pts );
+		}
+	}
+
+	{
+		std::unique_lock<std::mutex> lock( convarMutex );
+		threadEvent.notify_all();
+	}
+
+	// the queues are at their limit, the caller works off what didn't fit
+	ranByCaller += overflow.size();
+	for( const PartitionedTaskSet& it : overflow )
+	{
+		runPartition( it, numThreads );
+	}
+}
+
+bool TaskScheduler::runPendingTask()
+{
+	PartitionedTaskSet pTask;
+	if( popAny( pTask ) )
+	{
+		runPartition( pTask, numThreads );
+		return true;
+	}
+
+	return false;
+}
+
+void TaskScheduler::runOnMainThread( std::function<void()> fn )
+{
+	{
+		std::unique_lock<std::mutex> lock( mainThreadMutex );
+		mainThreadQueue.push_back( std::move( fn ) );
+	}
+	mainThreadEvent.notify_one();
+}
+
+size_t TaskScheduler::runMainThreadTasks()
+{
+	// swapped out so the functions run without the lock and can queue more
+	// work, which runs on the next call
+	std::vector<std::function<void()>> queued;
+	{
+		std::unique_lock<std::mutex> lock( mainThreadMutex );
+		queued.swap( mainThreadQueue );
+	}
+
+	for( auto& fn : queued )
+	{
+		fn();
+	}
+
+	return queued.size();
+}
+
+void TaskScheduler::waitForMainThreadTasks()
+{
+	std::unique_lock<std::mutex> lock( mainThreadMutex );
+	mainThreadEvent.wait( lock, [this]() { return !mainThreadQueue.empty(); } );
 }
 
 void TaskScheduler::waitFor( RangedTask* task )
 {
+	PartitionedTaskSet pTask;
+
 	while( !task->isComplete() )
 	{
+		// help out instead of spinning, any queued partition gets the workers to this task sooner
+		if( popAny( pTask ) )
+		{
+			runPartition( pTask, numThreads );
+			continue;
+		}
+
+		// the rest is already running on the workers, the predicate is checked 
+		// under the lock so a completion between the check and the wait isn't lost
+		std::unique_lock<std::mutex> lock( completionMutex );
+		completionEvent.wait( lock, [&]() { return task->isComplete(); } );
 	}
 }
 
@@ -3,13 +3,19 @@
 #include <thread>
 #include <memory>
 #include <array>
+#include <mutex>
 #include <atomic>
 #include <memory>
 #include <vector>
 #include <thread>
+#include <functional>
 #include <condition_variable>
+#include <algorithm>
+#include <type_traits>
 #include <boost/lockfree/queue.hpp>
 
+#include "taskProfiler.hpp"
+
 // the scheduler will split the container to these ranges 
 struct TaskRange
 {
@@ -17,6 +23,20 @@ struct TaskRange
 	size_t end;
 };
 
+/*
+	frame tasks are the work a frame waits for (systems, views). background 
+	tasks (asset decoding, loading) only run on the workers that are left 
+	over and never on a thread that is waiting for a frame task, so they 
+	can't hold up the frame.
+*/
+enum class enu_TASK_PRIORITY
+{
+	frame		= 0,
+	background	= 1
+};
+
+constexpr size_t TaskPriorityCount = 2;
+
 // the scheduler will accept references to classes derived from this 
 class RangedTask
 {
@@ -25,12 +45,23 @@ class RangedTask
 
 	// the number of partitions the task scheduler still has to process, 
 	// not the number of elements in the range  
-	std::atomic<int> rangesLeftToProcess;
+	std::atomic<int> rangesLeftToProcess{ 0 };
 	bool isComplete() const;
 
+protected:
+	// heap allocated tasks nobody waits for, the scheduler deletes them after 
+	// their last partition. set by the task itself, see taskFuture.hpp
+	bool deleteWhenDone = false;
+
 public:
 	size_t rangeSize = 1;
+	// elements per partition, 0 lets the scheduler pick a few partitions per worker
+	size_t grainSize = 0;
+	enu_TASK_PRIORITY priority = enu_TASK_PRIORITY::frame;
+	// shown in the profiler timeline, the type name is used if there is none
+	const char* name = nullptr;
 	virtual void execute( const TaskRange& range ) = 0;
+	virtual ~RangedTask() = default;
 };
 
 // the scheduler will distribute these to the queues 
@@ -40,38 +71,261 @@ struct PartitionedTaskSet
 	RangedTask* task;
 };
 
-// accepts RangedTasks and runs it's execute() concurrently
+// task objects behind parallelFor/parallelReduce, they live on the caller's stack
+template <typename Fn> class ParallelForTask : public RangedTask
+{
+	Fn&		fn;
+	size_t	begin;
+public:
+	ParallelForTask( Fn& fn, const size_t begin, const size_t end, const size_t grain ) 
+		: fn( fn ), begin( begin )
+	{
+		rangeSize = end - begin;
+		grainSize = grain;
+		name = "parallelFor";
+	}
+
+	void execute( const TaskRange& range ) override
+	{
+		for ( size_t i = range.start; i < range.end; i++ )
+		{
+			fn( begin + i );
+		}
+	}
+};
+
+template <typename T, typename Map, typename Combine> class ParallelReduceTask : public RangedTask
+{
+public:
+	// partial results are kept per partition and combined in order, so the
+	// result doesn't depend on which worker finished first
+	static constexpr size_t MaxPartitions = 64;
+
+	std::array<T, MaxPartitions> partials;
+	const T&	identity;
+	Map&		map;
+	Combine&	combine;
+	size_t		begin;
+
+	ParallelReduceTask( const size_t begin, const size_t end, const T& identity, Map& map, 
+		Combine& combine, const size_t partitions )	
+		: identity( identity ), map( map ), combine( combine ), begin( begin )
+	{
+		rangeSize = end - begin;
+		grainSize = std::max<size_t>( ( rangeSize + partitions - 1 ) / partitions, 1 );
+		name = "parallelReduce";
+	}
+
+	void execute( const TaskRange& range ) override
+	{
+		T partial = identity;
+		for ( size_t i = range.start; i < range.end; i++ )
+		{
+			partial = combine( partial, map( begin + i ) );
+		}
+
+		partials[range.start / grainSize] = partial;
+	}
+};
+
+// fill level of the task queues, for backpressure and diagnostics
+struct TaskQueueStats
+{
+	// partitions waiting in the queues right now, over both priorities
+	size_t queued			= 0;
+	size_t queuedBackground	= 0;
+	size_t queuedHighWater	= 0;
+	// partitions the submitting thread ran itself because the queues were at their limit
+	size_t ranByCaller		= 0;
+};
+
+// how initialize() sets up the workers, the application fills it in from the ts_* cvars
+struct TaskSchedulerConfig
+{
+	// 0 starts one worker per cpu the process may use, minus one if the main thread's is reserved
+	size_t	threads				= 0;
+	// binds every worker to its own cpu so the os doesn't migrate it between cores
+	bool	pinWorkers			= false;
+	// keeps the first cpu out of the workers' way. with pinWorkers the main thread is pinned
+	// to it until shutdown(), without it the cpu is only one worker less busy
+	bool	reserveMainThread	= true;
+};
+
+/*
+	accepts RangedTasks and runs it's execute() concurrently
+
+	A task is cut into grainSize partitions which are spread over the 
+	worker queues. Workers take from their own queue first and steal 
+	from the others once it runs dry, so an expensive partition doesn't 
+	leave the rest of the workers idle.
+
+	Every worker has a queue per priority and drains the frame queues 
+	(its own, then the others) before it looks at background work. At 
+	most all but one worker run background partitions at a time.
+
+	The queues grow with the amount of submitted work. An optional limit
+	on queued frame partitions makes execute() run the excess on the 
+	calling thread instead, the stats report how often that happened.
+
+	Work that has to stay on the main thread (Lua, GLFW, Vulkan submits) 
+	goes through runOnMainThread() and runs when the main loop calls 
+	runMainThreadTasks().
+*/
 class TaskScheduler
 {
-	using TaskQueue_t = boost::lockfree::queue<PartitionedTaskSet,
-		boost::lockfree::fixed_sized<true>,
-		boost::lockfree::capacity<64>>;
+	// node based, allocates more nodes when the preallocated ones run out
+	using TaskQueue_t = boost::lockfree::queue<PartitionedTaskSet>;
 
-	bool					isShuttingDown{ false };
+	std::atomic<bool>		isShuttingDown{ false };
 
 	std::vector<std::thread> threads;
-	TaskQueue_t*			taskQueues;
+	// one queue per worker and priority
+	std::array<std::vector<std::unique_ptr<TaskQueue_t>>, TaskPriorityCount> taskQueues;
+
+	// partitions pushed but not popped yet, over every queue of a priority
+	std::array<std::atomic<size_t>, TaskPriorityCount> queuedPartitions;
+	std::atomic<size_t>		queuedHighWater{ 0 };
+	std::atomic<size_t>		ranByCaller{ 0 };
+	// 0 means unlimited
+	size_t					queueLimit = 0;
+
+	// workers busy with a background partition and how many may be at once
+	std::atomic<size_t>		runningBackground{ 0 };
+	size_t					backgroundSlots = 0;
+
+	std::mutex							mainThreadMutex;
+	std::vector<std::function<void()>>	mainThreadQueue;
+	// signalled when a function is queued, waitForMainThreadTasks sleeps on it
+	std::condition_variable				mainThreadEvent;
 
 	// for shutdown and new tasks 
 	std::mutex				convarMutex;
 	std::condition_variable threadEvent;
 
+	// signalled when the last partition of a task finishes, waitFor sleeps on it
+	std::mutex				completionMutex;
+	std::condition_variable completionEvent;
+
 	// for shutting down 
 	std::atomic<int>		runningThreads;
 	size_t					numThreads;
+	size_t					pinnedThreads = 0;
+	// cpus the main thread was allowed on before initialize() pinned it, empty if it wasn't
+	std::vector<size_t>		mainThreadCpus;
+
+	// queue the next task's first partition goes to, rotates so tasks don't pile up on queue 0
+	std::atomic<size_t>		nextQueue{ 0 };
 
-	// parses the taskset into chunks 
-	std::vector<PartitionedTaskSet> divideTask( RangedTask* task );
+	TaskProfiler			profiler;
+
+	// elements per partition of the task
+	size_t grainOf( const RangedTask* task ) const;
+
+	// false if the queue is at its limit or out of memory
+	bool push( const enu_TASK_PRIORITY priority, const size_t queueIndex, const PartitionedTaskSet& pTask );
+	bool pop( const enu_TASK_PRIORITY priority, const size_t queueIndex, PartitionedTaskSet& pTask );
+	// takes a partition from any queue of the priority but the worker's own
+	bool steal( const enu_TASK_PRIORITY priority, const size_t thiefIndex, PartitionedTaskSet& pTask );
+	// takes a frame partition from any queue, for threads that aren't workers
+	bool popAny( PartitionedTaskSet& pTask );
+	// false if every background slot is taken
+	bool acquireBackgroundSlot();
+	void releaseBackgroundSlot();
+	bool hasQueuedWork() const;
+	// thread is the worker index, numThreads for any other thread
+	void runPartition( const PartitionedTaskSet& pTask, const size_t thread );
 
 	// the threads will run this function 
 	void threadFn( const size_t queueIndex );
 
 	static std::unique_ptr<TaskScheduler> _instance;
 public:
+	// partitions per worker when a task doesn't set a grain size, leaves room to balance
+	static constexpr size_t AutoPartitionsPerThread = 8;
+
 	void initialize( const size_t nThreads = std::thread::hardware_concurrency() );
+	void initialize( const TaskSchedulerConfig& config );
+
+	// number of worker threads, 0 if the scheduler isn't running
+	size_t getThreadCount() const;
+	// workers bound to a cpu, pinning isn't supported on every platform
+	size_t getPinnedThreadCount() const;
+	bool isMainThreadPinned() const;
+	// cpus the process may run on, what the automatic worker count is based on
+	static size_t getAvailableCpuCount();
+
+	// most partitions allowed to wait in the queues, 0 for no limit
+	void setQueueLimit( const size_t limit );
+	TaskQueueStats getQueueStats() const;
+
+	// per thread counters and the task timeline, disabled by default
+	TaskProfiler& getProfiler()
+	{
+		return profiler;
+	}
 	
 	void execute( RangedTask* task );
+	// runs queued frame partitions on the calling thread until the task is done,
+	// sleeps if only partitions running on other threads are left
 	void waitFor( RangedTask* task );
+	// runs one queued frame partition on the calling thread, false if there is none
+	bool runPendingTask();
+
+	// queues fn for the main thread, can be called from any thread
+	void runOnMainThread( std::function<void()> fn );
+	// runs everything queued with runOnMainThread() so far on the calling thread, 
+	// which has to be the main thread. returns the number of functions run
+	size_t runMainThreadTasks();
+	// sleeps until something is queued with runOnMainThread(), main thread only
+	void waitForMainThreadTasks();
+
+	// calls fn( i ) for every i in [begin, end) on the workers and waits for it, 
+	// grain 0 picks the partition size automatically
+	template <typename Fn> void parallelFor( const size_t begin, const size_t end, 
+		const size_t grain, Fn&& fn )
+	{
+		if ( end <= begin )
+		{
+			return;
+		}
+
+		ParallelForTask<std::remove_reference_t<Fn>> task( fn, begin, end, grain );
+		execute( &task );
+		waitFor( &task );
+	}
+
+	/*
+		combine( ... combine( identity, map( begin ) ) ..., map( end - 1 ) ) computed
+		on the workers. identity has to be neutral for combine (0 for a sum) as every 
+		partition starts from it, and combine has to be associative. T needs a default 
+		constructor.
+	*/
+	template <typename T, typename Map, typename Combine> T parallelReduce( const size_t begin, 
+		const size_t end, const T& identity, Map&& map, Combine&& combine )
+	{
+		if ( end <= begin )
+		{
+			return identity;
+		}
+
+		using Task_t = ParallelReduceTask<T, std::remove_reference_t<Map>, std::remove_reference_t<Combine>>;
+
+		const size_t partitions = std::min( { end - begin, Task_t::MaxPartitions,
+			std::max<size_t>( numThreads, 1 ) * AutoPartitionsPerThread } );
+		Task_t task( begin, end, identity, map, combine, partitions );
+
+		execute( &task );
+		waitFor( &task );
+
+		T result = identity;
+		const size_t count = ( task.rangeSize + task.grainSize - 1 ) / task.grainSize;
+		for ( size_t i = 0; i < count; i++ )
+		{
+			result = combine( result, task.partials[i] );
+		}
+
+		return result;
+	}
 
 	// shuts down the system and waits for threads to join
 	void shutdown();
@@ -2,8 +2,14 @@
 
 #include <vector>
 #include <string>
+#include <cstdint>
 
-#define UNSET_ID	-1
-#define UNSET_S		"__unset"
+#define UNSET_ID		-1
+#define UNSET_S			"__unset"
+#define UNSET_HANDLE	UINT32_MAX
+
+// interned resource names, see ResourceManager::getMeshHandle/getTextureHandle
+using MeshHandle	= uint32_t;
+using TextureHandle	= uint32_t;
 
 std::vector<std::string> SplitString( const std::string &text, char sep );
\ No newline at end of file
@@ -0,0 +1,261 @@
+#include <boost/test/unit_test.hpp>
+#include <array>
+#include <cmath>
+#include <vector>
+#include <random>
+
+#include "benchmark.hpp"
+#include "collision.hpp"
+
+namespace utf = boost::unit_test_framework;
+
+using Triangle = std::array<glm::vec3, 3>;
+
+// rolling terrain with a field of pillars on it, roughly the triangle count of a doom level
+std::vector<Triangle> BenchmarkLevel( const int gridSize )
+{
+	std::vector<Triangle> triangles;
+
+	auto height = []( const int x, const int z )
+	{
+		return std::sin( x * 0.3f ) * 2.f + std::cos( z * 0.2f ) * 2.f;
+	};
+
+	for ( int x = 0; x < gridSize; x++ )
+	{
+		for ( int z = 0; z < gridSize; z++ )
+		{
+			const glm::vec3 a( (float)x, height( x, z ), (float)z );
+			const glm::vec3 b( (float)x + 1, height( x + 1, z ), (float)z );
+			const glm::vec3 c( (float)x, height( x, z + 1 ), (float)z + 1 );
+			const glm::vec3 d( (float)x + 1, height( x + 1, z + 1 ), (float)z + 1 );
+
+			triangles.push_back( { a, b, c } );
+			triangles.push_back( { b, d, c } );
+		}
+	}
+
+	// four walls per pillar, every eighth cell
+	for ( int x = 4; x < gridSize; x += 8 )
+	{
+		for ( int z = 4; z < gridSize; z += 8 )
+		{
+			const glm::vec3 corners[4] = {
+				glm::vec3( x, -5.f, z ), glm::vec3( x + 1, -5.f, z ),
+				glm::vec3( x + 1, -5.f, z + 1 ), glm::vec3( x, -5.f, z + 1 ) };
+
+			for ( int i = 0; i < 4; i++ )
+			{
+				const glm::vec3 p0 = corners[i];
+				const glm::vec3 p1 = corners[( i + 1 ) % 4];
+				const glm::vec3 up( 0.f, 15.f, 0.f );
+
+				triangles.push_back( { p0, p1, p1 + up } );
+				triangles.push_back( { p0, p1 + up, p0 + up } );
+			}
+		}
+	}
+
+	return triangles;
+}
+
+struct BenchmarkRay
+{
+	glm::vec3	origin;
+	glm::vec3	dir;
+	float		length;
+};
+
+// short moves like the ones checkWorldCollision sees every frame
+std::vector<BenchmarkRay> BenchmarkRays( const size_t count, const int gridSize )
+{
+	std::mt19937 rng( 3 );
+	std::uniform_real_distribution<float> position( 0.f, (float)gridSize );
+	std::uniform_real_distribution<float> component( -1.f, 1.f );
+
+	std::vector<BenchmarkRay> rays;
+	for ( size_t i = 0; i < count; i++ )
+	{
+		const glm::vec3 move( component( rng ), component( rng ) - 0.5f, component( rng ) );
+		rays.push_back( { glm::vec3( position( rng ), 6.f, position( rng ) ), glm::normalize( move ),
+			glm::length( move ) * 4.f } );
+	}
+
+	return rays;
+}
+
+BOOST_AUTO_TEST_SUITE( CollisionBenchmarks, *utf::disabled() )
+
+// rays per second through the BVH against the linear scan checkWorldCollision used to do
+BOOST_AUTO_TEST_CASE( bvh_rays_per_second )
+{
+	const int gridSize = 128;
+	const std::vector<Triangle> level = BenchmarkLevel( gridSize );
+
+	BVH bvh;
+	const double buildMs = MeasureMs( [&]() { bvh.build( level ); }, 3 );
+
+	const std::vector<BenchmarkRay> bruteRays = BenchmarkRays( 500, gridSize );
+	const std::vector<BenchmarkRay> bvhRays = BenchmarkRays( 500'000, gridSize );
+
+	size_t bruteHits = 0;
+	const double bruteMs = MeasureMs( [&]()
+	{
+		bruteHits = 0;
+		for ( const BenchmarkRay& ray : bruteRays )
+		{
+			for ( const Triangle& triangle : level )
+			{
+				float t;
+				if ( RayTriangleIntersection( ray.origin, ray.dir, triangle, t ) && t <= ray.length )
+				{
+					bruteHits++;
+					break;
+				}
+			}
+		}
+	}, 3 );
+
+	size_t bvhHits = 0;
+	const double bvhMs = MeasureMs( [&]()
+	{
+		bvhHits = 0;
+		for ( const BenchmarkRay& ray : bvhRays )
+		{
+			RayHit hit;
+			if ( bvh.intersect( ray.origin, ray.dir, ray.length, hit ) )
+			{
+				bvhHits++;
+			}
+		}
+	}, 3 );
+
+	const double bruteRate = bruteRays.size() / bruteMs * 1'000.0;
+	const double bvhRate = bvhRays.size() / bvhMs * 1'000.0;
+
+	BOOST_TEST_MESSAGE( level.size() << " triangles, " << bvh.nodeCount() << " nodes, build " << buildMs << " ms" );
+	BOOST_TEST_MESSAGE( "  brute force " << bruteRate << " rays/s (" << bruteHits << " / " << bruteRays.size()
+		<< " hit), BVH " << bvhRate << " rays/s (" << bvhHits << " / " << bvhRays.size() << " hit), "
+		<< bvhRate / bruteRate << "x" );
+}
+
+// triangle tests per second of every ray/triangle kernel the cpu runs
+BOOST_AUTO_TEST_CASE( triangle_kernels )
+{
+	const int gridSize = 128;
+	const std::vector<Triangle> level = BenchmarkLevel( gridSize );
+	const std::vector<BenchmarkRay> rays = BenchmarkRays( 200, gridSize );
+
+	TriangleBatch batch;
+	batch.build( level );
+
+	size_t expectedHits = 0;
+	const double glmMs = MeasureMs( [&]()
+	{
+		expectedHits = 0;
+		for ( const BenchmarkRay& ray : rays )
+		{
+			float closest = ray.length;
+			bool found = false;
+			for ( const Triangle& triangle : level )
+			{
+				float t;
+				if ( RayTriangleIntersection( ray.origin, ray.dir, triangle, t ) && t <= closest )
+				{
+					closest = t;
+					found = true;
+				}
+			}
+
+			expectedHits += found ? 1 : 0;
+		}
+	}, 3 );
+
+	const double tests = (double)rays.size() * level.size();
+	BOOST_TEST_MESSAGE( level.size() << " triangles, " << rays.size() << " rays: RayTriangleIntersection " 
+		<< tests / glmMs / 1'000.0 << " M tests/s" );
+
+	const char* names[] = { "scalar", "sse", "avx" };
+	for ( int simd = 0; simd <= (int)DetectSimdLevel(); simd++ )
+	{
+		size_t hits = 0;
+		const double ms = MeasureMs( [&]()
+		{
+			hits = 0;
+			for ( const BenchmarkRay& ray : rays )
+			{
+				float closest = ray.length;
+				uint32_t index;
+				hits += RayTrianglesIntersection( ray.origin, ray.dir, batch, 0, batch.size(), closest, index,
+					(enu_SIMD_LEVEL)simd ) ? 1 : 0;
+			}
+		}, 3 );
+
+		BOOST_TEST_MESSAGE( "  " << names[simd] << " " << tests / ms / 1'000.0 << " M tests/s (" << glmMs / ms 
+			<< "x), " << hits << " / " << expectedHits << " hits" );
+	}
+}
+
+// 10k bodies wandering around a level sized area, the grid is rebuilt every frame like getCandidatePairs() does
+BOOST_AUTO_TEST_CASE( broadphase_moving_bodies )
+{
+	std::mt19937 rng( 9 );
+	std::uniform_real_distribution<float> position( 0.f, 400.f );
+	std::uniform_real_distribution<float> component( -1.f, 1.f );
+
+	for ( const size_t count : { 1'000, 10'000, 50'000 } )
+	{
+		std::vector<glm::vec3> positions;
+		std::vector<glm::vec3> velocities;
+		for ( size_t i = 0; i < count; i++ )
+		{
+			positions.push_back( glm::vec3( position( rng ), position( rng ) * 0.05f, position( rng ) ) );
+			velocities.push_back( glm::vec3( component( rng ), 0.f, component( rng ) ) * 0.5f );
+		}
+
+		const float radius = 0.5f;
+		SpatialHashGrid grid;
+		std::vector<BodyPair> pairs;
+
+		const double gridMs = MeasureMs( [&]()
+		{
+			for ( size_t i = 0; i < count; i++ )
+			{
+				positions[i] += velocities[i];
+			}
+
+			grid.clear();
+			for ( const glm::vec3& p : positions )
+			{
+				grid.add( p - glm::vec3( radius ), p + glm::vec3( radius ) );
+			}
+
+			pairs.clear();
+			grid.findPairs( pairs );
+		}, 20 );
+
+		// the all pairs loop only for the sizes it finishes in reasonable time
+		double bruteMs = 0.0;
+		size_t brutePairs = 0;
+		if ( count <= 10'000 )
+		{
+			bruteMs = MeasureMs( [&]()
+			{
+				brutePairs = 0;
+				for ( size_t a = 0; a < count; a++ )
+				{
+					for ( size_t b = a + 1; b < count; b++ )
+					{
+						const glm::vec3 d = glm::abs( positions[a] - positions[b] );
+						brutePairs += d.x <= 2.f * radius && d.y <= 2.f * radius && d.z <= 2.f * radius ? 1 : 0;
+					}
+				}
+			}, 1 );
+		}
+
+		BOOST_TEST_MESSAGE( count << " bodies: spatial hash " << gridMs << " ms/frame (" << pairs.size() 
+			<< " pairs), all pairs " << bruteMs << " ms (" << brutePairs << " pairs)" );
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
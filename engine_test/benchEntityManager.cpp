@@ -0,0 +1,150 @@
+#include <boost/test/unit_test.hpp>
+#include <map>
+#include <random>
+#include <typeinfo>
+#include <algorithm>
+
+#include "benchmark.hpp"
+#include "components.hpp"
+#include "entityManager.hpp"
+
+namespace utf = boost::unit_test_framework;
+
+// components used to carry a vtable, the replica keeps it for a fair comparison
+struct LegacyComponent
+{
+	virtual ~LegacyComponent() = default;
+};
+template <typename T> struct Legacy : public LegacyComponent, public T {};
+
+// replica of the map of unique_ptr layout the EntityManager used before the component pools 
+struct LegacyComponentStorage
+{
+	std::map<const std::type_info*, std::vector<std::unique_ptr<LegacyComponent>>> componentMap;
+	std::map<E_ID, Vi_ID> virtualIds;
+
+	template<typename T> T* get( E_ID id )
+	{
+		return static_cast<Legacy<T>*>( componentMap.at( &typeid( T ) ).at( virtualIds.at( id ).v ).get() );
+	}
+};
+
+// every entity has a transform, every second one a rigidbody like the PhysicsSystem input
+void RunIterationBenchmark( const size_t count )
+{
+	EntityManager* em = EntityManager::instance();
+	em->shutdown();
+	em->initialize();
+
+	LegacyComponentStorage legacy;
+	legacy.componentMap[&typeid( TransformComponent )].resize( count );
+	legacy.componentMap[&typeid( RigidbodyComponent )].resize( count );
+
+	std::vector<E_ID> entities;
+	entities.reserve( count );
+
+	for ( size_t i = 0; i < count; i++ )
+	{
+		E_ID id = em->addEntity();
+		em->add<TransformComponent>( id );
+
+		legacy.virtualIds[id] = Vi_ID( (long)i );
+		legacy.componentMap[&typeid( TransformComponent )][i] = std::make_unique<Legacy<TransformComponent>>();
+
+		if ( i % 2 == 0 )
+		{
+			em->add<RigidbodyComponent>( id )->velocity = glm::vec3( 1.f );
+			legacy.componentMap[&typeid( RigidbodyComponent )][i] = std::make_unique<Legacy<RigidbodyComponent>>();
+			legacy.get<RigidbodyComponent>( id )->velocity = glm::vec3( 1.f );
+		}
+
+		entities.push_back( id );
+	}
+
+	double legacyMs = MeasureMs( [&]() {
+		for ( E_ID ent : entities )
+		{
+			RigidbodyComponent* rbc = legacy.get<RigidbodyComponent>( ent );
+			if ( rbc == nullptr )
+			{
+				continue;
+			}
+
+			legacy.get<TransformComponent>( ent )->position += rbc->velocity * 0.016f;
+		}
+	} );
+
+	double poolMs = MeasureMs( [&]() {
+		em->each<TransformComponent, RigidbodyComponent>( []( E_ID, TransformComponent& tc, RigidbodyComponent& rbc ) {
+			tc.position += rbc.velocity * 0.016f;
+		} );
+	} );
+
+	BOOST_TEST_MESSAGE( count << " entities: map of unique_ptr " << legacyMs 
+		<< " ms, component pools " << poolMs << " ms" );
+
+	em->shutdown();
+}
+
+// random access E_ID lookups through the old std::map virtualization and the slot map
+void RunIdLookupBenchmark( const size_t count )
+{
+	EntityManager* em = EntityManager::instance();
+	em->shutdown();
+	em->initialize();
+
+	std::map<E_ID, Vi_ID> virtualIds;
+	std::vector<E_ID> lookups;
+	lookups.reserve( count );
+
+	for ( size_t i = 0; i < count; i++ )
+	{
+		E_ID id = em->addEntity();
+		em->add<TransformComponent>( id );
+		virtualIds[id] = Vi_ID( (long)i );
+
+		lookups.push_back( id );
+	}
+
+	std::shuffle( lookups.begin(), lookups.end(), std::mt19937( 42 ) );
+
+	size_t found = 0;
+
+	double mapMs = MeasureMs( [&]() {
+		for ( E_ID id : lookups )
+		{
+			auto it = virtualIds.find( id );
+			found += it != virtualIds.end() ? 1 : 0;
+		}
+	} );
+
+	double slotMs = MeasureMs( [&]() {
+		for ( E_ID id : lookups )
+		{
+			found += em->get<TransformComponent>( id ) != nullptr ? 1 : 0;
+		}
+	} );
+
+	BOOST_TEST_MESSAGE( count << " ids: std::map " << ( count / mapMs / 1000.0 ) << " M lookups/s, slot map " 
+		<< ( count / slotMs / 1000.0 ) << " M lookups/s (" << found << ")" );
+
+	em->shutdown();
+}
+
+BOOST_AUTO_TEST_SUITE( EntityManagerBenchmarks, *utf::disabled() )
+
+BOOST_AUTO_TEST_CASE( component_iteration )
+{
+	RunIterationBenchmark( 10'000 );
+	RunIterationBenchmark( 100'000 );
+	RunIterationBenchmark( 1'000'000 );
+}
+
+BOOST_AUTO_TEST_CASE( id_lookup )
+{
+	RunIdLookupBenchmark( 10'000 );
+	RunIdLookupBenchmark( 100'000 );
+	RunIdLookupBenchmark( 1'000'000 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
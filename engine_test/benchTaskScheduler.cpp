@@ -0,0 +1,223 @@
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <thread>
+#include <algorithm>
+
+#include "benchmark.hpp"
+#include "components.hpp"
+#include "entityManager.hpp"
+#include "taskScheduler.hpp"
+#include "parallel.hpp"
+
+namespace utf = boost::unit_test_framework;
+
+// physics-like per entity work, heavy enough that the split overhead doesn't dominate
+void IntegrateBody( E_ID, TransformComponent& tc, RigidbodyComponent& rbc )
+{
+	glm::vec3 forces = tc.impulseForces + glm::vec3( 0.f, -0.4f, 0.f );
+
+	for ( int i = 0; i < 16; i++ )
+	{
+		forces.x = std::sin( forces.x + tc.position.y ) * 0.5f;
+		forces.z = std::cos( forces.z + tc.position.x ) * 0.5f;
+	}
+
+	tc.position += forces;
+	rbc.velocity = forces;
+}
+
+// the last eighth of the range costs 32x as much as the rest, like a crowded corner of a level
+class SkewedTask : public RangedTask
+{
+public:
+	std::vector<float> values;
+
+	explicit SkewedTask( const size_t count ) : values( count, 1.f )
+	{
+		rangeSize = count;
+	}
+
+	void execute( const TaskRange& range ) override
+	{
+		const size_t heavyStart = values.size() - values.size() / 8;
+
+		for ( size_t i = range.start; i < range.end; i++ )
+		{
+			const int iterations = i >= heavyStart ? 256 : 8;
+			for ( int n = 0; n < iterations; n++ )
+			{
+				values[i] = std::sqrt( values[i] + (float)n );
+			}
+		}
+	}
+};
+
+// the a_million_doubles workload written as a RangedTask subclass
+class Doubler : public RangedTask
+{
+public:
+	std::vector<double>& input;
+	std::vector<double>& output;
+
+	Doubler( std::vector<double>& input, std::vector<double>& output ) : input( input ), output( output )
+	{
+		rangeSize = input.size();
+	}
+
+	void execute( const TaskRange& range ) override
+	{
+		for ( size_t i = range.start; i < range.end; i++ )
+		{
+			output[i] = input[i] + input[i];
+		}
+	}
+};
+
+BOOST_AUTO_TEST_SUITE( TaskSchedulerBenchmarks, *utf::disabled() )
+
+// the same view walked with 1, 2, 4 ... hardware_concurrency workers
+BOOST_AUTO_TEST_CASE( view_scaling )
+{
+	const size_t count = 200'000;
+
+	EntityManager* em = EntityManager::instance();
+	em->shutdown();
+	em->initialize();
+
+	for ( E_ID id : em->addEntities( count ) )
+	{
+		em->add<TransformComponent>( id )->position = glm::vec3( (float)id.v, 0.f, 0.f );
+		em->add<RigidbodyComponent>( id );
+	}
+
+	View<TransformComponent, RigidbodyComponent>& view = em->view<TransformComponent, RigidbodyComponent>();
+	const double serialMs = MeasureMs( [&]() { view.each( IntegrateBody ); } );
+
+	BOOST_TEST_MESSAGE( count << " entities: View::each " << serialMs << " ms" );
+
+	TaskScheduler* ts = TaskScheduler::instance();
+	const size_t maxThreads = std::max<size_t>( std::thread::hardware_concurrency(), 1 );
+
+	for ( size_t threads = 1; ; threads = std::min( threads * 2, maxThreads ) )
+	{
+		ts->initialize( threads );
+		const double parallelMs = MeasureMs( [&]() { parallelForEach( view, IntegrateBody ); } );
+		ts->shutdown();
+
+		BOOST_TEST_MESSAGE( "  parallelForEach, " << threads << " threads: " << parallelMs 
+			<< " ms (" << serialMs / parallelMs << "x)" );
+
+		if ( threads == maxThreads )
+		{
+			break;
+		}
+	}
+
+	em->shutdown();
+}
+
+// one partition per worker (the old static split) against finer grains with stealing
+BOOST_AUTO_TEST_CASE( skewed_cost )
+{
+	const size_t count = 1'000'000;
+	const size_t threads = std::max<size_t>( std::thread::hardware_concurrency(), 2 );
+
+	TaskScheduler* ts = TaskScheduler::instance();
+	ts->initialize( threads );
+
+	SkewedTask task( count );
+	auto run = [&]( const size_t grain )
+	{
+		task.grainSize = grain;
+		return MeasureMs( [&]() { ts->execute( &task ); ts->waitFor( &task ); } );
+	};
+
+	const double staticMs = run( ( count + threads - 1 ) / threads );
+	const double autoMs = run( 0 );
+	const double fineMs = run( 1024 );
+
+	BOOST_TEST_MESSAGE( count << " skewed elements, " << threads << " threads: static split " << staticMs 
+		<< " ms, auto grain " << autoMs << " ms (" << staticMs / autoMs << "x), grain 1024 " 
+		<< fineMs << " ms (" << staticMs / fineMs << "x)" );
+
+	ts->shutdown();
+}
+
+// the lambda helpers against a hand written RangedTask and a plain loop
+BOOST_AUTO_TEST_CASE( lambda_helpers )
+{
+	const size_t count = 4'000'000;
+
+	TaskScheduler* ts = TaskScheduler::instance();
+	ts->initialize();
+
+	std::vector<double> input( count, 1.5 );
+	std::vector<double> output( count );
+
+	const double serialMs = MeasureMs( [&]()
+	{
+		for ( size_t i = 0; i < count; i++ )
+		{
+			output[i] = input[i] + input[i];
+		}
+	} );
+
+	Doubler doubler( input, output );
+	const double taskMs = MeasureMs( [&]() { ts->execute( &doubler ); ts->waitFor( &doubler ); } );
+	const double forMs = MeasureMs( [&]() 
+	{ 
+		ts->parallelFor( 0, count, 0, [&]( size_t i ) { output[i] = input[i] + input[i]; } );
+	} );
+
+	double serialSum = 0.0;
+	const double serialSumMs = MeasureMs( [&]()
+	{
+		serialSum = 0.0;
+		for ( size_t i = 0; i < count; i++ )
+		{
+			serialSum += output[i];
+		}
+	} );
+
+	double sum = 0.0;
+	const double reduceMs = MeasureMs( [&]()
+	{
+		sum = ts->parallelReduce( 0, count, 0.0, [&]( size_t i ) { return output[i]; }, 
+			[]( double a, double b ) { return a + b; } );
+	} );
+
+	BOOST_TEST_MESSAGE( count << " doubles, " << ts->getThreadCount() << " threads: loop " << serialMs 
+		<< " ms, RangedTask " << taskMs << " ms, parallelFor " << forMs << " ms" );
+	BOOST_TEST_MESSAGE( "  sum: loop " << serialSumMs << " ms, parallelReduce " << reduceMs 
+		<< " ms (" << sum << " / " << serialSum << ")" );
+
+	ts->shutdown();
+}
+
+// the a_million_doubles workload with free and pinned workers, both leaving a cpu to the main thread
+BOOST_AUTO_TEST_CASE( pinned_vs_unpinned )
+{
+	const size_t count = 1'000'000;
+
+	std::vector<double> input( count, 1.5 );
+	std::vector<double> output( count );
+
+	TaskScheduler* ts = TaskScheduler::instance();
+	TaskSchedulerConfig config;
+
+	for ( const bool pin : { false, true } )
+	{
+		config.pinWorkers = pin;
+		ts->initialize( config );
+
+		Doubler doubler( input, output );
+		const double ms = MeasureMs( [&]() { ts->execute( &doubler ); ts->waitFor( &doubler ); }, 200 );
+
+		BOOST_TEST_MESSAGE( count << " doubles, " << ts->getThreadCount() << " threads, " 
+			<< ts->getPinnedThreadCount() << " pinned: " << ms << " ms, " << count / ms / 1'000.0 << " M/s" );
+
+		ts->shutdown();
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <chrono>
+#include <boost/test/unit_test.hpp>
+
+/*
+	Helpers for the benchmark suites. These are disabled by default, run 
+	them explicitly with: 
+		engine_test.exe --run_test=<SuiteName> --log_level=message
+*/
+
+// runs fn repeats times and returns the average wall time in milliseconds
+template <typename Fn> double MeasureMs( Fn&& fn, const int repeats = 10 )
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	for ( int i = 0; i < repeats; i++ )
+	{
+		fn();
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+
+	return std::chrono::duration<double, std::milli>( end - start ).count() / repeats;
+}
\ No newline at end of file
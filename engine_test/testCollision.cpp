@@ -0,0 +1,576 @@
+#include <boost/test/unit_test.hpp>
+#include <set>
+#include <array>
+#include <vector>
+#include <random>
+
+#include "collision.hpp"
+
+BOOST_AUTO_TEST_SUITE( CollisionTests )
+
+using Triangle = std::array<glm::vec3, 3>;
+
+// small triangles scattered in a box, like the faces of a level but without the structure
+std::vector<Triangle> RandomTriangles( const size_t count, std::mt19937& rng )
+{
+	std::uniform_real_distribution<float> position( -50.f, 50.f );
+	std::uniform_real_distribution<float> offset( -2.f, 2.f );
+
+	std::vector<Triangle> triangles;
+	for ( size_t i = 0; i < count; i++ )
+	{
+		const glm::vec3 center( position( rng ), position( rng ), position( rng ) );
+		triangles.push_back( {
+			center + glm::vec3( offset( rng ), offset( rng ), offset( rng ) ),
+			center + glm::vec3( offset( rng ), offset( rng ), offset( rng ) ),
+			center + glm::vec3( offset( rng ), offset( rng ), offset( rng ) ) } );
+	}
+
+	return triangles;
+}
+
+glm::vec3 RandomDirection( std::mt19937& rng )
+{
+	std::uniform_real_distribution<float> component( -1.f, 1.f );
+
+	glm::vec3 dir( 0.f );
+	while ( glm::length( dir ) < 0.01f )
+	{
+		dir = glm::vec3( component( rng ), component( rng ), component( rng ) );
+	}
+
+	return glm::normalize( dir );
+}
+
+// the closest hit the BVH finds is the one the linear scan finds
+BOOST_AUTO_TEST_CASE( bvh_matches_brute_force )
+{
+	std::mt19937 rng( 7 );
+	const std::vector<Triangle> triangles = RandomTriangles( 3'000, rng );
+
+	BVH bvh;
+	bvh.build( triangles );
+
+	std::uniform_real_distribution<float> position( -60.f, 60.f );
+
+	size_t hits = 0;
+	bool matching = true;
+	for ( size_t i = 0; i < 2'000; i++ )
+	{
+		const glm::vec3 origin( position( rng ), position( rng ), position( rng ) );
+		const glm::vec3 dir = RandomDirection( rng );
+		const float maxDistance = 40.f;
+
+		bool expected = false;
+		float expectedDistance = maxDistance;
+		for ( const Triangle& triangle : triangles )
+		{
+			float t;
+			if ( RayTriangleIntersection( origin, dir, triangle, t ) && t <= expectedDistance )
+			{
+				expected = true;
+				expectedDistance = t;
+			}
+		}
+
+		RayHit hit;
+		const bool found = bvh.intersect( origin, dir, maxDistance, hit );
+
+		matching = matching && found == expected;
+		if ( found && expected )
+		{
+			hits++;
+			float t;
+			matching = matching && hit.distance == expectedDistance &&
+				RayTriangleIntersection( origin, dir, triangles[hit.triangle], t ) && t == hit.distance;
+		}
+	}
+
+	BOOST_TEST( matching == true );
+	BOOST_TEST( hits > 100 );
+}
+
+// every triangle ends up in exactly one leaf and children stay inside their parents
+BOOST_AUTO_TEST_CASE( bvh_structure )
+{
+	std::mt19937 rng( 11 );
+	const std::vector<Triangle> triangles = RandomTriangles( 5'000, rng );
+
+	BVH bvh;
+	bvh.build( triangles );
+
+	const std::vector<BVHNode>& nodes = bvh.getNodes();
+	BOOST_REQUIRE( nodes.empty() == false );
+	BOOST_TEST( nodes.size() < triangles.size() * 2 );
+
+	size_t leafTriangles = 0;
+	bool contained = true;
+	for ( size_t i = 0; i < nodes.size(); i++ )
+	{
+		if ( nodes[i].count > 0 )
+		{
+			leafTriangles += nodes[i].count;
+			continue;
+		}
+
+		for ( const BVHNode& child : { nodes[i + 1], nodes[nodes[i].offset] } )
+		{
+			contained = contained && glm::all( glm::greaterThanEqual( child.boundsMin, nodes[i].boundsMin ) ) &&
+				glm::all( glm::lessThanEqual( child.boundsMax, nodes[i].boundsMax ) );
+		}
+	}
+
+	BOOST_TEST( leafTriangles == triangles.size() );
+	BOOST_TEST( contained == true );
+}
+
+// every kernel the cpu runs gives the same hits as RayTriangleIntersection, bit for bit
+BOOST_AUTO_TEST_CASE( simd_kernels_match_scalar )
+{
+	std::mt19937 rng( 5 );
+	std::vector<Triangle> triangles = RandomTriangles( 1'000, rng );
+
+	// collapsed triangles and flat ones facing the straight down rays below
+	for ( size_t i = 0; i < triangles.size(); i += 10 )
+	{
+		triangles[i][2] = triangles[i][1];
+		triangles[i + 1][0].y = triangles[i + 1][1].y = triangles[i + 1][2].y;
+	}
+
+	TriangleBatch batch;
+	batch.build( triangles );
+	BOOST_REQUIRE( batch.size() == triangles.size() );
+
+	std::uniform_real_distribution<float> position( -60.f, 60.f );
+	std::uniform_int_distribution<size_t> start( 0, triangles.size() - 20 );
+	std::uniform_int_distribution<size_t> length( 1, 19 );
+
+	size_t hits = 0;
+	bool matching = true;
+	for ( size_t i = 0; i < 20'000; i++ )
+	{
+		const size_t first = start( rng );
+		const size_t count = length( rng );
+
+		// half the rays aim at a triangle of the range so there is something to hit
+		const glm::vec3 origin( position( rng ), position( rng ), position( rng ) );
+		const Triangle& target = triangles[first + i % count];
+		const glm::vec3 dir = i % 2 == 0 ? RandomDirection( rng ) : 
+			i % 4 == 1 ? glm::vec3( 0.f, -1.f, 0.f ) :
+			glm::normalize( ( target[0] + target[1] + target[2] ) * ( 1.f / 3.f ) - origin );
+
+		bool expected = false;
+		float expectedDistance = 100.f;
+		uint32_t expectedIndex = 0;
+		for ( size_t n = first; n < first + count; n++ )
+		{
+			float t;
+			if ( RayTriangleIntersection( origin, dir, triangles[n], t ) && t <= expectedDistance )
+			{
+				expected = true;
+				expectedDistance = t;
+				expectedIndex = (uint32_t)n;
+			}
+		}
+
+		hits += expected ? 1 : 0;
+
+		for ( int level = 0; level <= (int)DetectSimdLevel(); level++ )
+		{
+			float distance = 100.f;
+			uint32_t index = 0;
+			const bool found = RayTrianglesIntersection( origin, dir, batch, first, count, distance, index,
+				(enu_SIMD_LEVEL)level );
+
+			matching = matching && found == expected && distance == expectedDistance && index == expectedIndex;
+		}
+	}
+
+	BOOST_TEST( matching == true );
+	BOOST_TEST( hits > 1'000 );
+}
+
+BOOST_AUTO_TEST_CASE( bvh_edge_cases )
+{
+	BVH bvh;
+	RayHit hit;
+
+	bvh.build( {} );
+	BOOST_TEST( bvh.empty() == true );
+	BOOST_TEST( bvh.intersect( glm::vec3( 0.f ), glm::vec3( 0.f, -1.f, 0.f ), 10.f, hit ) == false );
+
+	// a thousand copies of the same floor triangle, no plane separates them
+	const Triangle floor = { glm::vec3( -1.f, 0.f, -1.f ), glm::vec3( 1.f, 0.f, -1.f ), glm::vec3( 0.f, 0.f, 1.f ) };
+	bvh.build( std::vector<Triangle>( 1'000, floor ) );
+
+	BOOST_TEST( bvh.intersect( glm::vec3( 0.f, 2.f, 0.f ), glm::vec3( 0.f, -1.f, 0.f ), 10.f, hit ) == true );
+	BOOST_TEST( hit.distance == 2.f );
+	BOOST_TEST( hit.point.y == 0.f );
+
+	// out of reach
+	BOOST_TEST( bvh.intersect( glm::vec3( 0.f, 2.f, 0.f ), glm::vec3( 0.f, -1.f, 0.f ), 1.5f, hit ) == false );
+	// pointing away
+	BOOST_TEST( bvh.intersect( glm::vec3( 0.f, 2.f, 0.f ), glm::vec3( 0.f, 1.f, 0.f ), 10.f, hit ) == false );
+}
+
+BOOST_AUTO_TEST_CASE( sweep_sphere_triangle )
+{
+	const Triangle floor = { glm::vec3( -1.f, 0.f, -1.f ), glm::vec3( 1.f, 0.f, -1.f ), glm::vec3( 0.f, 0.f, 1.f ) };
+	SweepHit hit;
+
+	// onto the face
+	BOOST_TEST( SweepSphereTriangle( glm::vec3( 0.f, 2.f, 0.f ), 0.5f, glm::vec3( 0.f, -3.f, 0.f ), floor, hit ) == true );
+	BOOST_TEST( hit.time == 0.5f );
+	BOOST_TEST( hit.normal.y == 1.f );
+	BOOST_TEST( hit.point.y == 0.f );
+
+	// from below, the triangle has two sides
+	BOOST_TEST( SweepSphereTriangle( glm::vec3( 0.f, -2.f, 0.f ), 0.5f, glm::vec3( 0.f, 3.f, 0.f ), floor, hit ) == true );
+	BOOST_TEST( hit.normal.y == -1.f );
+
+	// onto the corner at ( 1, 0, -1 ) from straight above, the center stops radius above it
+	BOOST_TEST( SweepSphereTriangle( glm::vec3( 1.f, 2.f, -1.f ), 0.5f, glm::vec3( 0.f, -3.f, 0.f ), floor, hit ) == true );
+	BOOST_TEST( hit.time == 0.5f, boost::test_tools::tolerance( 1e-5f ) );
+	BOOST_TEST( glm::length( hit.point - glm::vec3( 1.f, 0.f, -1.f ) ) < 1e-5f );
+
+	// past the back edge from the side, the contact is on the edge and the normal points back at the center
+	BOOST_TEST( SweepSphereTriangle( glm::vec3( 0.f, 0.f, -3.f ), 0.5f, glm::vec3( 0.f, 0.f, 4.f ), floor, hit ) == true );
+	BOOST_TEST( hit.time == 0.375f, boost::test_tools::tolerance( 1e-5f ) );
+	BOOST_TEST( hit.point.z == -1.f, boost::test_tools::tolerance( 1e-5f ) );
+	BOOST_TEST( hit.normal.z == -1.f, boost::test_tools::tolerance( 1e-5f ) );
+
+	// parallel above the face, short of it and away from it
+	BOOST_TEST( SweepSphereTriangle( glm::vec3( -3.f, 1.f, 0.f ), 0.5f, glm::vec3( 6.f, 0.f, 0.f ), floor, hit ) == false );
+	BOOST_TEST( SweepSphereTriangle( glm::vec3( 0.f, 2.f, 0.f ), 0.5f, glm::vec3( 0.f, -1.f, 0.f ), floor, hit ) == false );
+	BOOST_TEST( SweepSphereTriangle( glm::vec3( 0.f, 2.f, 0.f ), 0.5f, glm::vec3( 0.f, 1.f, 0.f ), floor, hit ) == false );
+
+	// resting on it: pushing in hits right away, leaving or sliding along is free
+	BOOST_TEST( SweepSphereTriangle( glm::vec3( 0.f, 0.4f, 0.f ), 0.5f, glm::vec3( 0.f, -1.f, 0.f ), floor, hit ) == true );
+	BOOST_TEST( hit.time == 0.f );
+	BOOST_TEST( hit.normal.y == 1.f );
+	BOOST_TEST( SweepSphereTriangle( glm::vec3( 0.f, 0.4f, 0.f ), 0.5f, glm::vec3( 0.f, 1.f, 0.f ), floor, hit ) == false );
+	BOOST_TEST( SweepSphereTriangle( glm::vec3( 0.f, 0.4f, 0.f ), 0.5f, glm::vec3( 0.1f, 0.f, 0.f ), floor, hit ) == false );
+}
+
+// the BVH finds the same first contact as sweeping against every triangle
+BOOST_AUTO_TEST_CASE( bvh_sweep_matches_brute_force )
+{
+	std::mt19937 rng( 17 );
+	const std::vector<Triangle> triangles = RandomTriangles( 2'000, rng );
+
+	BVH bvh;
+	bvh.build( triangles );
+
+	std::uniform_real_distribution<float> position( -60.f, 60.f );
+	std::uniform_real_distribution<float> length( 1.f, 30.f );
+	std::uniform_real_distribution<float> radius( 0.1f, 2.f );
+
+	size_t hits = 0;
+	size_t mismatches = 0;
+	for ( size_t i = 0; i < 1'000; i++ )
+	{
+		const glm::vec3 center( position( rng ), position( rng ), position( rng ) );
+		const glm::vec3 motion = RandomDirection( rng ) * length( rng );
+		const float r = radius( rng );
+
+		bool expected = false;
+		float expectedTime = 1.f;
+		for ( const Triangle& triangle : triangles )
+		{
+			SweepHit hit;
+			if ( SweepSphereTriangle( center, r, motion, triangle, hit ) && hit.time <= expectedTime )
+			{
+				expected = true;
+				expectedTime = hit.time;
+			}
+		}
+
+		SweepHit hit;
+		const bool found = bvh.sweepSphere( center, r, motion, hit );
+
+		// the BVH rebuilds the vertices from v0 and the edges, grazing contacts may round either way
+		if ( found != expected || ( found && std::abs( hit.time - expectedTime ) > 1e-4f ) )
+		{
+			mismatches++;
+		}
+
+		hits += found ? 1 : 0;
+	}
+
+	BOOST_TEST( mismatches <= 2 );
+	BOOST_TEST( hits > 100 );
+}
+
+// axis aligned rays and sweeps starting exactly on a face of a box they run parallel to, 
+// like gravity along the edge of a level
+BOOST_AUTO_TEST_CASE( bvh_axis_aligned_on_face )
+{
+	// a 10 x 10 floor at y = 0, two triangles per unit square
+	std::vector<Triangle> triangles;
+	for ( int x = 0; x < 10; x++ )
+	{
+		for ( int z = 0; z < 10; z++ )
+		{
+			const glm::vec3 corner( float( x ), 0.f, float( z ) );
+			triangles.push_back( { corner, corner + glm::vec3( 1.f, 0.f, 0.f ), corner + glm::vec3( 0.f, 0.f, 1.f ) } );
+			triangles.push_back( { corner + glm::vec3( 1.f, 0.f, 0.f ), corner + glm::vec3( 1.f, 0.f, 1.f ), 
+				corner + glm::vec3( 0.f, 0.f, 1.f ) } );
+		}
+	}
+
+	BVH bvh;
+	bvh.build( triangles );
+
+	const glm::vec3 down( 0.f, -1.f, 0.f );
+	size_t mismatches = 0;
+	for ( const glm::vec3& origin : { glm::vec3( 0.f, 5.f, 5.f ), glm::vec3( 10.f, 5.f, 5.f ), 
+		glm::vec3( 5.f, 5.f, 0.f ), glm::vec3( 5.f, 5.f, 10.f ), glm::vec3( 0.f, 5.f, 0.f ), glm::vec3( 3.f, 5.f, 3.f ) } )
+	{
+		bool expected = false;
+		for ( const Triangle& triangle : triangles )
+		{
+			float t;
+			expected = expected || RayTriangleIntersection( origin, down, triangle, t );
+		}
+
+		RayHit hit;
+		mismatches += bvh.intersect( origin, down, 100.f, hit ) != expected ? 1 : 0;
+	}
+
+	// the sphere's box grown by the radius starts on the floor's side faces
+	const float radius = 0.5f;
+	const glm::vec3 motion( 0.f, -5.f, 0.f );
+	for ( const glm::vec3& center : { glm::vec3( -0.5f, 2.f, 5.f ), glm::vec3( 10.5f, 2.f, 5.f ), 
+		glm::vec3( 5.f, 2.f, -0.5f ), glm::vec3( 5.f, 2.f, 10.5f ) } )
+	{
+		bool expected = false;
+		for ( const Triangle& triangle : triangles )
+		{
+			SweepHit hit;
+			expected = expected || SweepSphereTriangle( center, radius, motion, triangle, hit );
+		}
+
+		SweepHit hit;
+		mismatches += bvh.sweepSphere( center, radius, motion, hit ) != expected ? 1 : 0;
+	}
+
+	BOOST_TEST( mismatches == 0 );
+
+	// straight down along the floor's edge
+	RayHit hit;
+	BOOST_TEST( bvh.intersect( glm::vec3( 0.f, 5.f, 5.f ), down, 100.f, hit ) == true );
+	BOOST_TEST( hit.distance == 5.f );
+}
+
+// motion into a wall or a floor keeps the part that runs along it
+BOOST_AUTO_TEST_CASE( capsule_slides_along_surfaces )
+{
+	// a floor at y = 0 and a wall at x = 5, both 20 units wide
+	const std::vector<Triangle> level = {
+		{ glm::vec3( -10.f, 0.f, -10.f ), glm::vec3( 10.f, 0.f, -10.f ), glm::vec3( 10.f, 0.f, 10.f ) },
+		{ glm::vec3( -10.f, 0.f, -10.f ), glm::vec3( 10.f, 0.f, 10.f ), glm::vec3( -10.f, 0.f, 10.f ) },
+		{ glm::vec3( 5.f, -10.f, -10.f ), glm::vec3( 5.f, 10.f, -10.f ), glm::vec3( 5.f, 10.f, 10.f ) },
+		{ glm::vec3( 5.f, -10.f, -10.f ), glm::vec3( 5.f, 10.f, 10.f ), glm::vec3( 5.f, -10.f, 10.f ) } };
+
+	BVH bvh;
+	bvh.build( level );
+
+	// a standing character, the capsule reaches from its eyes 1.5 units down
+	const float radius = 0.5f;
+	glm::vec3 eyes( 0.f, 2.01f, 0.f );
+
+	glm::vec3 moved;
+	SweepHit hit;
+
+	// walking and falling at once, only the fall is stopped
+	glm::vec3 velocity( 3.f, -20.f, 0.f );
+	BOOST_TEST( bvh.slideCapsule( eyes, eyes - glm::vec3( 0.f, 1.5f, 0.f ), radius, glm::vec3( 1.f, -1.f, 0.5f ), 
+		moved, hit, &velocity ) == true );
+	BOOST_TEST( hit.normal.y == 1.f, boost::test_tools::tolerance( 1e-5f ) );
+	BOOST_TEST( velocity.x == 3.f, boost::test_tools::tolerance( 1e-5f ) );
+	BOOST_TEST( velocity.y == 0.f, boost::test_tools::tolerance( 1e-5f ) );
+	BOOST_TEST( moved.x == 1.f, boost::test_tools::tolerance( 1e-4f ) );
+	BOOST_TEST( moved.z == 0.5f, boost::test_tools::tolerance( 1e-4f ) );
+	BOOST_TEST( moved.y <= 0.f );
+	BOOST_TEST( eyes.y - 1.5f + moved.y >= radius );
+
+	// diagonally into the wall, the capsule stops a skin short of it and keeps walking along it
+	eyes = glm::vec3( 4.f, 2.1f, 0.f );
+	BOOST_TEST( bvh.slideCapsule( eyes, eyes - glm::vec3( 0.f, 1.5f, 0.f ), radius, glm::vec3( 2.f, 0.f, 2.f ), 
+		moved, hit ) == true );
+	BOOST_TEST( hit.normal.x == -1.f, boost::test_tools::tolerance( 1e-5f ) );
+	BOOST_TEST( eyes.x + moved.x <= 5.f - radius );
+	BOOST_TEST( eyes.x + moved.x >= 5.f - radius - 2.f * BVH::SkinWidth );
+	BOOST_TEST( moved.z > 1.9f );
+	BOOST_TEST( moved.y == 0.f, boost::test_tools::tolerance( 1e-5f ) );
+
+	// nothing in the way
+	BOOST_TEST( bvh.slideCapsule( eyes, eyes - glm::vec3( 0.f, 1.5f, 0.f ), radius, glm::vec3( -1.f, 0.f, 0.f ), 
+		moved, hit ) == false );
+	BOOST_TEST( moved.x == -1.f );
+
+	// a fast move can't tunnel through the wall
+	BOOST_TEST( bvh.slideCapsule( eyes, eyes - glm::vec3( 0.f, 1.5f, 0.f ), radius, glm::vec3( 50.f, 0.f, 0.f ), 
+		moved, hit ) == true );
+	BOOST_TEST( eyes.x + moved.x <= 5.f - radius );
+}
+
+// walking into a step climbs it when it is low enough, a higher one is a wall
+BOOST_AUTO_TEST_CASE( capsule_climbs_steps )
+{
+	// a floor at y = 0 up to x = 2, then a step 0.3 high
+	const std::vector<Triangle> level = {
+		{ glm::vec3( -10.f, 0.f, -10.f ), glm::vec3( 2.f, 0.f, -10.f ), glm::vec3( 2.f, 0.f, 10.f ) },
+		{ glm::vec3( -10.f, 0.f, -10.f ), glm::vec3( 2.f, 0.f, 10.f ), glm::vec3( -10.f, 0.f, 10.f ) },
+		{ glm::vec3( 2.f, 0.f, -10.f ), glm::vec3( 2.f, 0.3f, -10.f ), glm::vec3( 2.f, 0.3f, 10.f ) },
+		{ glm::vec3( 2.f, 0.f, -10.f ), glm::vec3( 2.f, 0.3f, 10.f ), glm::vec3( 2.f, 0.f, 10.f ) },
+		{ glm::vec3( 2.f, 0.3f, -10.f ), glm::vec3( 10.f, 0.3f, -10.f ), glm::vec3( 10.f, 0.3f, 10.f ) },
+		{ glm::vec3( 2.f, 0.3f, -10.f ), glm::vec3( 10.f, 0.3f, 10.f ), glm::vec3( 2.f, 0.3f, 10.f ) } };
+
+	BVH bvh;
+	bvh.build( level );
+
+	// standing on the floor, walking and falling a little like every physics step
+	const float radius = 0.25f;
+	const glm::vec3 eyes( 0.f, 1.f + radius + BVH::SkinWidth, 0.f );
+	const glm::vec3 feet = eyes - glm::vec3( 0.f, 1.f, 0.f );
+	const glm::vec3 motion( 3.f, -0.05f, 0.f );
+
+	glm::vec3 moved;
+	SweepHit hit;
+
+	// too low to climb
+	BOOST_TEST( bvh.slideCapsule( eyes, feet, radius, motion, moved, hit, nullptr, 0.2f ) == true );
+	BOOST_TEST( feet.x + moved.x <= 2.f - radius );
+
+	// up the step and on along its top, the fall into it is gone
+	glm::vec3 velocity( 10.f, -5.f, 0.f );
+	BOOST_TEST( bvh.slideCapsule( eyes, feet, radius, motion, moved, hit, &velocity, 0.4f ) == true );
+	BOOST_TEST( moved.x == 3.f, boost::test_tools::tolerance( 1e-4f ) );
+	BOOST_TEST( feet.y + moved.y >= 0.3f + radius );
+	BOOST_TEST( feet.y + moved.y <= 0.3f + radius + 2.f * BVH::SkinWidth );
+	BOOST_TEST( velocity.x == 10.f );
+	BOOST_TEST( velocity.y == 0.f, boost::test_tools::tolerance( 1e-5f ) );
+
+	// no steps by default
+	BOOST_TEST( bvh.slideCapsule( eyes, feet, radius, motion, moved, hit ) == true );
+	BOOST_TEST( feet.x + moved.x <= 2.f - radius );
+}
+
+// the grid reports exactly the overlapping pairs the O(n^2) loop finds, each of them once
+BOOST_AUTO_TEST_CASE( spatial_hash_pairs )
+{
+	std::mt19937 rng( 13 );
+	std::uniform_real_distribution<float> position( -40.f, 40.f );
+	std::uniform_real_distribution<float> radius( 0.1f, 3.f );
+
+	std::vector<std::pair<glm::vec3, glm::vec3>> boxes;
+	for ( size_t i = 0; i < 2'000; i++ )
+	{
+		const glm::vec3 center( position( rng ), position( rng ) * 0.1f, position( rng ) );
+		// a few big ones span many cells
+		const float r = i % 100 == 0 ? 15.f : radius( rng );
+		boxes.push_back( { center - glm::vec3( r ), center + glm::vec3( r ) } );
+	}
+
+	std::set<std::pair<uint32_t, uint32_t>> expected;
+	for ( uint32_t a = 0; a < boxes.size(); a++ )
+	{
+		for ( uint32_t b = a + 1; b < boxes.size(); b++ )
+		{
+			if ( glm::all( glm::lessThanEqual( boxes[a].first, boxes[b].second ) ) &&
+				glm::all( glm::lessThanEqual( boxes[b].first, boxes[a].second ) ) )
+			{
+				expected.insert( { a, b } );
+			}
+		}
+	}
+
+	// automatic, tiny and huge cells only change the speed
+	for ( const float cellSize : { 0.f, 0.5f, 100.f } )
+	{
+		SpatialHashGrid grid;
+		grid.setCellSize( cellSize );
+		for ( const auto& box : boxes )
+		{
+			grid.add( box.first, box.second );
+		}
+
+		std::vector<BodyPair> pairs;
+		grid.findPairs( pairs );
+
+		std::set<std::pair<uint32_t, uint32_t>> found;
+		bool ordered = true;
+		for ( const BodyPair& pair : pairs )
+		{
+			found.insert( { pair.a, pair.b } );
+			ordered = ordered && pair.a < pair.b;
+		}
+
+		BOOST_TEST( pairs.size() == found.size() );
+		BOOST_TEST( ( found == expected ) );
+		BOOST_TEST( ordered == true );
+	}
+
+	BOOST_TEST( expected.size() > 100 );
+
+	SpatialHashGrid empty;
+	std::vector<BodyPair> pairs;
+	empty.findPairs( pairs );
+	empty.add( glm::vec3( 0.f ), glm::vec3( 1.f ) );
+	empty.findPairs( pairs );
+	BOOST_TEST( pairs.empty() == true );
+}
+
+// boxes far past the int range of the cells and boxes covering the whole level still pair up right
+BOOST_AUTO_TEST_CASE( spatial_hash_far_and_huge )
+{
+	const std::vector<std::pair<glm::vec3, glm::vec3>> boxes = {
+		{ glm::vec3( -1.f ), glm::vec3( 1.f ) },
+		{ glm::vec3( 0.5f ), glm::vec3( 2.f ) },
+		{ glm::vec3( 5.f ), glm::vec3( 6.f ) },
+		{ glm::vec3( 1e12f ), glm::vec3( 1.5e12f ) },
+		{ glm::vec3( 1.2e12f ), glm::vec3( 2e12f ) },
+		{ glm::vec3( 3e12f ), glm::vec3( 4e12f ) },
+		{ glm::vec3( -2e12f ), glm::vec3( -1e12f ) },
+		{ glm::vec3( -1e6f ), glm::vec3( 1e6f ) },
+		{ glm::vec3( 0.f, -1e6f, 0.f ), glm::vec3( 1e6f, 0.f, 1e6f ) },
+		{ glm::vec3( 5.5f ), glm::vec3( 5.6f ) } };
+
+	std::set<std::pair<uint32_t, uint32_t>> expected;
+	for ( uint32_t a = 0; a < boxes.size(); a++ )
+	{
+		for ( uint32_t b = a + 1; b < boxes.size(); b++ )
+		{
+			if ( glm::all( glm::lessThanEqual( boxes[a].first, boxes[b].second ) ) &&
+				glm::all( glm::lessThanEqual( boxes[b].first, boxes[a].second ) ) )
+			{
+				expected.insert( { a, b } );
+			}
+		}
+	}
+
+	SpatialHashGrid grid;
+	grid.setCellSize( 1.f );
+	for ( const auto& box : boxes )
+	{
+		grid.add( box.first, box.second );
+	}
+
+	std::vector<BodyPair> pairs;
+	grid.findPairs( pairs );
+
+	std::set<std::pair<uint32_t, uint32_t>> found;
+	for ( const BodyPair& pair : pairs )
+	{
+		BOOST_TEST( pair.a < pair.b );
+		found.insert( { pair.a, pair.b } );
+	}
+
+	BOOST_TEST( pairs.size() == found.size() );
+	BOOST_TEST( ( found == expected ) );
+	BOOST_TEST( found.count( { 3u, 4u } ) == 1 );
+	BOOST_TEST( found.count( { 7u, 8u } ) == 1 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
@@ -1,4 +1,7 @@
 #include <boost/test/unit_test.hpp>
+#include <set>
+#include <string>
+#include <algorithm>
 
 #include "utils.hpp"
 #include "components.hpp"
@@ -76,4 +79,285 @@ BOOST_AUTO_TEST_CASE( id_validation )
 	BOOST_TEST( invalid_id_new_generation == false );
 }
 
+// each must visit exactly the entities owning every requested component 
+BOOST_AUTO_TEST_CASE( component_iteration )
+{
+	EntityManager* em = EntityManager::instance();
+	em->registerComponent<TransformComponent>();
+	em->registerComponent<RigidbodyComponent>();
+
+	E_ID both = em->addEntity();
+	E_ID transformOnly = em->addEntity();
+	E_ID removed = em->addEntity();
+
+	em->add<TransformComponent>( both )->position = glm::vec3( 1.f, 2.f, 3.f );
+	em->add<RigidbodyComponent>( both );
+	em->add<TransformComponent>( transformOnly );
+	em->add<TransformComponent>( removed );
+	em->add<RigidbodyComponent>( removed );
+
+	// removing from the middle of the pool must not disturb the other entries 
+	em->removeEntity( removed );
+
+	int visited = 0;
+	bool matched = true;
+	em->each<TransformComponent, RigidbodyComponent>( [&]( E_ID id, TransformComponent& tc, RigidbodyComponent& ) {
+		visited++;
+		matched = matched && id == both && tc.position == glm::vec3( 1.f, 2.f, 3.f );
+	} );
+
+	BOOST_TEST( visited == 1 );
+	BOOST_TEST( matched == true );
+	BOOST_TEST( em->get<RigidbodyComponent>( transformOnly ) == nullptr );
+
+	em->removeEntity( both );
+	em->removeEntity( transformOnly );
+}
+
+// type ids must be unique per type and stable between calls 
+BOOST_AUTO_TEST_CASE( component_type_ids )
+{
+	size_t transformId = ComponentTypeId::get<TransformComponent>();
+	size_t meshId = ComponentTypeId::get<MeshComponent>();
+
+	BOOST_TEST( transformId != meshId );
+	BOOST_TEST( transformId == ComponentTypeId::get<TransformComponent>() );
+}
+
+// handles from an older generation must not reach the entity reusing the slot 
+BOOST_AUTO_TEST_CASE( stale_id_rejection )
+{
+	EntityManager* em = EntityManager::instance();
+	em->registerComponent<TransformComponent>();
+
+	E_ID old = em->addEntity();
+	em->add<TransformComponent>( old );
+	em->removeEntity( old );
+
+	// spawn until the freed slot is handed out again 
+	std::vector<E_ID> spawned;
+	do
+	{
+		spawned.push_back( em->addEntity() );
+	} while ( spawned.back().v != old.v );
+
+	E_ID reused = spawned.back();
+	em->add<TransformComponent>( reused );
+
+	BOOST_TEST( em->isIdValid( old ) == false );
+	BOOST_TEST( em->get<TransformComponent>( old ) == nullptr );
+	BOOST_TEST( em->get<TransformComponent>( reused ) != nullptr );
+
+	for ( E_ID id : spawned )
+	{
+		em->removeEntity( id );
+	}
+}
+
+// batch creation hands out unique valid ids and batch removal invalidates them 
+BOOST_AUTO_TEST_CASE( bulk_entity_lifetime )
+{
+	EntityManager* em = EntityManager::instance();
+	em->registerComponent<TransformComponent>();
+	em->reserve( 1000 );
+
+	std::vector<E_ID> ids = em->addEntities( 1000 );
+	for ( E_ID id : ids )
+	{
+		em->add<TransformComponent>( id );
+	}
+
+	std::set<long> unique;
+	bool allValid = true;
+	for ( E_ID id : ids )
+	{
+		unique.insert( id.v );
+		allValid = allValid && em->isIdValid( id );
+	}
+
+	em->removeEntities( ids );
+
+	bool noneValid = std::none_of( ids.begin(), ids.end(), [em]( E_ID id ) {
+		return em->isIdValid( id );
+	} );
+
+	BOOST_TEST( ids.size() == 1000 );
+	BOOST_TEST( unique.size() == 1000 );
+	BOOST_TEST( allValid == true );
+	BOOST_TEST( noneValid == true );
+}
+
+// once the pool is warmed up, spawn/despawn churn must not go to the heap 
+BOOST_AUTO_TEST_CASE( steady_state_allocations )
+{
+	EntityManager* em = EntityManager::instance();
+	em->registerComponent<TransformComponent>();
+
+	auto churn = [em]() {
+		std::vector<E_ID> ids = em->addEntities( 2000 );
+		for ( E_ID id : ids )
+		{
+			em->add<TransformComponent>( id );
+		}
+		em->removeEntities( ids );
+	};
+
+	churn();
+	const size_t warmedUp = em->getPoolStats<TransformComponent>().heapAllocations;
+
+	for ( int i = 0; i < 10; i++ )
+	{
+		churn();
+	}
+
+	BOOST_TEST( warmedUp > 0 );
+	BOOST_TEST( em->getPoolStats<TransformComponent>().heapAllocations == warmedUp );
+	BOOST_TEST( em->getPoolStats<TransformComponent>().blocksInUse == 0 );
+}
+
+// clones get their own copy of every component 
+BOOST_AUTO_TEST_CASE( entity_cloning )
+{
+	EntityManager* em = EntityManager::instance();
+	em->registerComponent<TransformComponent>();
+	em->registerComponent<MeshComponent>();
+
+	E_ID source = em->addEntity();
+	em->add<TransformComponent>( source )->position = glm::vec3( 4.f, 5.f, 6.f );
+	em->add<MeshComponent>( source )->mesh = 7;
+
+	E_ID clone = em->cloneEntity( source );
+	em->get<MeshComponent>( source )->mesh = 9;
+
+	BOOST_TEST( em->isIdValid( clone ) == true );
+	BOOST_TEST( ( em->get<TransformComponent>( clone )->position == glm::vec3( 4.f, 5.f, 6.f ) ) );
+	BOOST_TEST( em->get<MeshComponent>( clone )->mesh == 7 );
+
+	em->removeEntity( source );
+	em->removeEntity( clone );
+}
+
+// the engine's components are all trivially copyable, this one takes the pool's 
+// construct/copy/move/destroy path
+class NameComponent : public Component
+{
+public:
+	// long enough to live on the heap
+	std::string name = "a name past the small string buffer";
+};
+
+// removal holes, clones and removed entities through the type table 
+BOOST_AUTO_TEST_CASE( non_trivial_components )
+{
+	EntityManager* em = EntityManager::instance();
+	em->registerComponent<NameComponent>();
+
+	std::vector<E_ID> ids = em->addEntities( 4 );
+	for ( E_ID id : ids )
+	{
+		em->add<NameComponent>( id )->name = "entity number " + std::to_string( id.v ) + " with a long name";
+	}
+	BOOST_TEST( em->getConst<NameComponent>( ids[0] )->name.size() > 15 );
+
+	// the last name is moved into the hole
+	em->remove<NameComponent>( ids[1] );
+	BOOST_TEST( em->getConst<NameComponent>( ids[1] ) == nullptr );
+	BOOST_TEST( em->getConst<NameComponent>( ids[3] )->name == "entity number " + std::to_string( ids[3].v ) + " with a long name" );
+
+	E_ID clone = em->cloneEntity( ids[3] );
+	em->get<NameComponent>( ids[3] )->name = "renamed after cloning";
+	BOOST_TEST( em->getConst<NameComponent>( clone )->name == "entity number " + std::to_string( ids[3].v ) + " with a long name" );
+
+	E_ID fresh = em->addEntity();
+	BOOST_TEST( em->add<NameComponent>( fresh )->name == "a name past the small string buffer" );
+
+	// every name left is destroyed with its entity
+	em->removeEntities( ids );
+	em->removeEntity( clone );
+	BOOST_TEST( em->getConst<NameComponent>( fresh )->name == "a name past the small string buffer" );
+	em->removeEntity( fresh );
+	BOOST_TEST( em->getPoolStats<NameComponent>().blocksInUse == 0 );
+}
+
+// views follow component adds and removes without rescanning 
+BOOST_AUTO_TEST_CASE( cached_views )
+{
+	EntityManager* em = EntityManager::instance();
+	em->registerComponent<TransformComponent>();
+	em->registerComponent<RigidbodyComponent>();
+
+	std::vector<E_ID> ids = em->addEntities( 10 );
+	for ( size_t i = 0; i < ids.size(); i++ )
+	{
+		em->add<TransformComponent>( ids[i] );
+		if ( i % 2 == 0 )
+		{
+			em->add<RigidbodyComponent>( ids[i] );
+		}
+	}
+
+	// created after the components, filled from the pools
+	View<TransformComponent, RigidbodyComponent>& view = em->view<TransformComponent, RigidbodyComponent>();
+	BOOST_TEST( view.size() == 5 );
+
+	em->add<RigidbodyComponent>( ids[1] );
+	em->remove<RigidbodyComponent>( ids[0] );
+	em->removeEntity( ids[2] );
+	E_ID clone = em->cloneEntity( ids[4] );
+
+	std::set<decltype( E_ID::v )> visited;
+	view.each( [&]( E_ID id, TransformComponent&, RigidbodyComponent& )
+	{
+		visited.insert( id.v );
+	} );
+
+	std::set<decltype( E_ID::v )> expected = { ids[1].v, ids[4].v, ids[6].v, ids[8].v, clone.v };
+	BOOST_TEST( ( visited == expected ) );
+	BOOST_TEST( ( &view == &em->view<TransformComponent, RigidbodyComponent>() ) );
+
+	// re-registering a component empties its pool and every view using it
+	em->registerComponent<RigidbodyComponent>();
+	BOOST_TEST( view.empty() );
+
+	em->removeEntities( ids );
+	em->removeEntity( clone );
+}
+
+// only components written since a tick are reported as changed
+BOOST_AUTO_TEST_CASE( change_tracking )
+{
+	EntityManager* em = EntityManager::instance();
+	em->registerComponent<TransformComponent>();
+
+	std::vector<E_ID> ids = em->addEntities( 4 );
+	for ( E_ID id : ids )
+	{
+		em->add<TransformComponent>( id );
+	}
+
+	const uint32_t tick = em->advanceChangeTick();
+	BOOST_TEST( em->changedSince<TransformComponent>( ids[0], tick ) == false );
+
+	em->get<TransformComponent>( ids[1] )->position.x = 1.f;
+	em->getConst<TransformComponent>( ids[2] );
+	em->markChanged<TransformComponent>( ids[3] );
+
+	std::set<decltype( E_ID::v )> changed;
+	em->eachChanged<TransformComponent>( tick, [&]( E_ID id, TransformComponent& )
+	{
+		changed.insert( id.v );
+	} );
+
+	std::set<decltype( E_ID::v )> expected = { ids[1].v, ids[3].v };
+	BOOST_TEST( ( changed == expected ) );
+
+	// marking through the component pointer, like the Lua setters do
+	const uint32_t next = em->advanceChangeTick();
+	em->markChanged( em->getConst<TransformComponent>( ids[0] ) );
+	BOOST_TEST( em->changedSince<TransformComponent>( ids[0], next ) == true );
+	BOOST_TEST( em->changedSince<TransformComponent>( ids[1], next ) == false );
+
+	em->removeEntities( ids );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include <boost/test/unit_test.hpp>
 #include "luaStateController.hpp"
+#include "components.hpp"
 
 BOOST_AUTO_TEST_SUITE( LuaStateControllerTests )
 
@@ -31,4 +32,72 @@ BOOST_AUTO_TEST_CASE( script_file_runner )
 	BOOST_TEST( res.valid() == true );
 }
 
+// proxies keep pointing at their entity's component when the pool moves it
+BOOST_AUTO_TEST_CASE( component_proxy )
+{
+	EntityManager* em = EntityManager::instance();
+	em->registerComponent<TransformComponent>();
+
+	std::vector<E_ID> ids = em->addEntities( 3 );
+	for ( E_ID id : ids )
+	{
+		em->add<TransformComponent>( id )->position.x = (float)id.v;
+	}
+
+	const LuaComponent<TransformComponent> proxy = { ids[2] };
+	const TransformComponent* before = proxy.read();
+
+	// the last component fills the hole of the removed one
+	em->remove<TransformComponent>( ids[0] );
+	BOOST_TEST( proxy.read() != before );
+	BOOST_TEST( proxy.read()->position.x == (float)ids[2].v );
+
+	proxy.write()->position.y = 1.f;
+	BOOST_TEST( em->getConst<TransformComponent>( ids[2] )->position.y == 1.f );
+
+	em->removeEntity( ids[2] );
+	BOOST_TEST( proxy.read() == nullptr );
+	BOOST_TEST( proxy.write() == nullptr );
+
+	em->removeEntities( ids );
+}
+
+// writes to a single axis of a component's vector land in the component
+BOOST_AUTO_TEST_CASE( component_vector_axis )
+{
+	EntityManager* em = EntityManager::instance();
+	em->registerComponent<TransformComponent>();
+
+	LuaStateController* lsc = LuaStateController::instance();
+	lsc->registerClasses();
+	lsc->registerFunctions();
+
+	const E_ID ent = em->addEntity();
+	em->add<TransformComponent>( ent );
+	const uint32_t tick = em->advanceChangeTick();
+	lsc->state["testEntity"] = ent;
+
+	sol::protected_function_result res = lsc->safeRunScript( R"(
+		local tc = GetTransformComponent( testEntity )
+		tc.position.x = 5
+		local scale = tc.scale
+		scale.y = 2
+		moved = tc.position + vec3.new( 1, 0, 0 )
+		readBack = tc.position.x
+	)" );
+	BOOST_REQUIRE( res.valid() == true );
+
+	const TransformComponent* tc = em->getConst<TransformComponent>( ent );
+	BOOST_TEST( tc->position.x == 5.f );
+	BOOST_TEST( tc->scale.y == 2.f );
+	BOOST_TEST( em->changedSince<TransformComponent>( ent, tick ) == true );
+
+	// still a vec3 for everything that takes one
+	const glm::vec3 moved = lsc->state["moved"].get<glm::vec3>();
+	BOOST_TEST( moved.x == 6.f );
+	BOOST_TEST( lsc->state["readBack"].get<float>() == 5.f );
+
+	em->removeEntity( ent );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
@@ -0,0 +1,241 @@
+#include <boost/test/unit_test.hpp>
+
+#include "cvar.hpp"
+#include "scene.hpp"
+#include "components.hpp"
+#include "entityManager.hpp"
+#include "sceneManager.hpp"
+#include "physicsSystem.hpp"
+
+extern CVar physics_hz;
+extern CVar physics_max_substeps;
+
+BOOST_AUTO_TEST_SUITE( PhysicsSystemTests )
+
+// only gravity moves it and there is nothing to collide with
+E_ID AddFallingBody( EntityManager* em )
+{
+	E_ID id = em->addEntity();
+	em->add<TransformComponent>( id );
+
+	RigidbodyComponent* rbc = em->add<RigidbodyComponent>( id );
+	rbc->affectedByGravity = true;
+	rbc->collidable = false;
+
+	return id;
+}
+
+// bodies of other scenes and bodies in no scene at all stay where they are
+BOOST_AUTO_TEST_CASE( active_scene_only )
+{
+	EntityManager* em = EntityManager::instance();
+	em->registerComponent<TransformComponent>();
+	em->registerComponent<RigidbodyComponent>();
+	em->registerComponent<MeshComponent>();
+	em->registerComponent<ActiveSceneComponent>();
+
+	SceneManager* sm = SceneManager::instance();
+	Scene* active = sm->getScene( sm->addScene( "physics_active_scene" ) );
+	Scene* other = sm->getScene( sm->addScene( "physics_other_scene" ) );
+
+	const E_ID member = AddFallingBody( em );
+	sm->addEntityToScene( active->id, member );
+
+	const E_ID otherMember = AddFallingBody( em );
+	sm->addEntityToScene( other->id, otherMember );
+
+	// removed members stay in the list, the slot may go to a body of no scene. 
+	// scripts hand in bare numbers that match any generation
+	const E_ID removed = em->addEntity();
+	sm->addEntityToScene( active->id, E_ID( removed.v ) );
+	em->removeEntity( removed );
+	const E_ID loose = AddFallingBody( em );
+
+	sm->setActiveScene( active->id );
+
+	// joins while the scene is active
+	const E_ID late = AddFallingBody( em );
+	sm->addEntityToScene( active->id, late );
+
+	// the scene has no world to collide with, the body falls like the others
+	const E_ID collider = AddFallingBody( em );
+	em->get<RigidbodyComponent>( collider )->collidable = true;
+	sm->addEntityToScene( active->id, collider );
+
+	physics_hz.setValue( "0" );
+	PhysicsSystem::instance()->update( 0.1f );
+
+	BOOST_TEST( em->getConst<TransformComponent>( member )->position.y < 0.f );
+	BOOST_TEST( em->getConst<TransformComponent>( late )->position.y < 0.f );
+	BOOST_TEST( em->getConst<TransformComponent>( collider )->position.y < 0.f );
+	BOOST_TEST( em->getConst<TransformComponent>( otherMember )->position.y == 0.f );
+	BOOST_TEST( em->getConst<TransformComponent>( loose )->position.y == 0.f );
+
+	// switching scenes pauses the bodies left behind
+	const float memberY = em->getConst<TransformComponent>( member )->position.y;
+	sm->setActiveScene( other->id );
+	PhysicsSystem::instance()->update( 0.1f );
+	physics_hz.setValue( physics_hz.defaultValue );
+
+	BOOST_TEST( em->getConst<TransformComponent>( member )->position.y == memberY );
+	BOOST_TEST( em->getConst<TransformComponent>( otherMember )->position.y < 0.f );
+
+	for ( E_ID id : { member, otherMember, loose, late, collider } )
+	{
+		em->removeEntity( id );
+	}
+}
+
+// overlapping bodies of the active scene, built when the pairs are asked for
+BOOST_AUTO_TEST_CASE( candidate_pairs )
+{
+	EntityManager* em = EntityManager::instance();
+	em->registerComponent<TransformComponent>();
+	em->registerComponent<RigidbodyComponent>();
+	em->registerComponent<MeshComponent>();
+	em->registerComponent<ActiveSceneComponent>();
+
+	SceneManager* sm = SceneManager::instance();
+	Scene* scene = sm->getScene( sm->addScene( "physics_pairs_scene" ) );
+
+	// resting bodies, without forces they never sweep through the world
+	auto addBody = [&]( const glm::vec3& position, const bool inScene )
+	{
+		E_ID id = em->addEntity();
+		em->add<TransformComponent>( id )->position = position;
+		em->add<RigidbodyComponent>( id );
+		if ( inScene )
+		{
+			sm->addEntityToScene( scene->id, id );
+		}
+
+		return id;
+	};
+
+	const E_ID a = addBody( glm::vec3( 0.f ), true );
+	const E_ID b = addBody( glm::vec3( 0.5f, 0.f, 0.f ), true );
+	const E_ID distant = addBody( glm::vec3( 10.f, 0.f, 0.f ), true );
+	const E_ID outside = addBody( glm::vec3( 0.2f, 0.f, 0.f ), false );
+
+	sm->setActiveScene( scene->id );
+	physics_hz.setValue( "0" );
+	PhysicsSystem::instance()->update( 0.016f );
+	physics_hz.setValue( physics_hz.defaultValue );
+
+	const std::vector<CollisionPair>& pairs = PhysicsSystem::instance()->getCandidatePairs();
+	BOOST_REQUIRE( pairs.size() == 1 );
+	BOOST_TEST( ( ( pairs[0].a == a && pairs[0].b == b ) || ( pairs[0].a == b && pairs[0].b == a ) ) );
+
+	for ( E_ID id : { a, b, distant, outside } )
+	{
+		em->removeEntity( id );
+	}
+}
+
+// the velocity keeps what gravity added in earlier steps, so the fall speeds up
+BOOST_AUTO_TEST_CASE( gravity_accumulates )
+{
+	EntityManager* em = EntityManager::instance();
+	em->registerComponent<TransformComponent>();
+	em->registerComponent<RigidbodyComponent>();
+	em->registerComponent<MeshComponent>();
+	em->registerComponent<ActiveSceneComponent>();
+
+	SceneManager* sm = SceneManager::instance();
+	Scene* scene = sm->getScene( sm->addScene( "physics_gravity_scene" ) );
+
+	const E_ID body = AddFallingBody( em );
+	sm->addEntityToScene( scene->id, body );
+	sm->setActiveScene( scene->id );
+
+	physics_hz.setValue( "0" );
+	PhysicsSystem::instance()->update( 0.1f );
+	const float firstFall = -em->getConst<TransformComponent>( body )->position.y;
+	const float firstVelocity = em->getConst<RigidbodyComponent>( body )->velocity.y;
+
+	PhysicsSystem::instance()->update( 0.1f );
+	const float secondFall = -em->getConst<TransformComponent>( body )->position.y - firstFall;
+	const float secondVelocity = em->getConst<RigidbodyComponent>( body )->velocity.y;
+	physics_hz.setValue( physics_hz.defaultValue );
+
+	BOOST_TEST( firstFall > 0.f );
+	BOOST_TEST( secondFall == 2.f * firstFall, boost::test_tools::tolerance( 1e-4f ) );
+	BOOST_TEST( secondVelocity == 2.f * firstVelocity, boost::test_tools::tolerance( 1e-4f ) );
+
+	// the last step's motion, not the velocity, it is what the render offset undoes
+	const RigidbodyComponent* rbc = em->getConst<RigidbodyComponent>( body );
+	BOOST_TEST( rbc->stepMotion.y == -secondFall, boost::test_tools::tolerance( 1e-4f ) );
+
+	em->removeEntity( body );
+}
+
+// fixed steps for known frame times, 64 hz so every time below adds up exactly
+BOOST_AUTO_TEST_CASE( fixed_steps )
+{
+	EntityManager* em = EntityManager::instance();
+	em->registerComponent<TransformComponent>();
+	em->registerComponent<RigidbodyComponent>();
+	em->registerComponent<MeshComponent>();
+	em->registerComponent<ActiveSceneComponent>();
+
+	SceneManager* sm = SceneManager::instance();
+	Scene* scene = sm->getScene( sm->addScene( "physics_steps_scene" ) );
+
+	const E_ID body = AddFallingBody( em );
+	sm->addEntityToScene( scene->id, body );
+	sm->setActiveScene( scene->id );
+
+	PhysicsSystem* ps = PhysicsSystem::instance();
+	const float stepSeconds = 1.f / 64.f;
+
+	// a variable step runs once per update, draws the body where it is and empties the accumulator
+	physics_hz.setValue( "0" );
+	ps->update( 0.05f );
+	BOOST_TEST( ps->getStepsLastUpdate() == 1 );
+	BOOST_TEST( ( em->getConst<TransformComponent>( body )->renderOffset == glm::vec3( 0.f ) ) );
+
+	physics_hz.setValue( "64" );
+	physics_max_substeps.setValue( "4" );
+
+	auto offsetIs = [&]( const float alpha )
+	{
+		const glm::vec3 expected = em->getConst<RigidbodyComponent>( body )->stepMotion * ( alpha - 1.f );
+		return em->getConst<TransformComponent>( body )->renderOffset == expected;
+	};
+
+	// half a step, nothing runs and the body is drawn half way through the last step
+	ps->update( stepSeconds * 0.5f );
+	BOOST_TEST( ps->getStepsLastUpdate() == 0 );
+	BOOST_TEST( offsetIs( 0.5f ) );
+
+	// with the left over half, exactly one step
+	const float beforeStep = em->getConst<TransformComponent>( body )->position.y;
+	ps->update( stepSeconds * 0.5f );
+	BOOST_TEST( ps->getStepsLastUpdate() == 1 );
+	BOOST_TEST( em->getConst<TransformComponent>( body )->position.y < beforeStep );
+	BOOST_TEST( offsetIs( 0.f ) );
+
+	ps->update( stepSeconds * 3.5f );
+	BOOST_TEST( ps->getStepsLastUpdate() == 3 );
+	BOOST_TEST( offsetIs( 0.5f ) );
+
+	// a long frame stops at the cap and the backlog past it is dropped,
+	// only the half step fmod keeps is left for the next frame
+	ps->update( 0.5f );
+	BOOST_TEST( ps->getStepsLastUpdate() == 4 );
+	BOOST_TEST( offsetIs( 0.5f ) );
+
+	ps->update( stepSeconds * 0.5f );
+	BOOST_TEST( ps->getStepsLastUpdate() == 1 );
+
+	physics_max_substeps.setValue( "2" );
+	ps->update( stepSeconds * 3.f );
+	BOOST_TEST( ps->getStepsLastUpdate() == 2 );
+
+	physics_hz.setValue( physics_hz.defaultValue );
+	physics_max_substeps.setValue( physics_max_substeps.defaultValue );
+
+	em->removeEntity( body );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
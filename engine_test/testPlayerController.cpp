@@ -63,4 +63,36 @@ BOOST_AUTO_TEST_CASE( valid_entity_usage )
 	BOOST_TEST( must_be_true_turn == true );
 }
 
+// space is held for several rendered frames before the next physics step runs
+BOOST_AUTO_TEST_CASE( jump_once_per_step )
+{
+	PlayerController* pc = PlayerController::instance();
+	EntityManager* em = EntityManager::instance();
+
+	em->shutdown();
+	em->initialize();
+
+	E_ID ent = em->addEntity();
+	em->add<TransformComponent>( ent );
+	em->add<RigidbodyComponent>( ent );
+	pc->setEntity( ent );
+
+	BOOST_TEST( pc->jump() == true );
+	const float launchSpeed = em->getConst<RigidbodyComponent>( ent )->velocity.y;
+	BOOST_TEST( launchSpeed > 0.f );
+
+	// the second frame finds the body already launched, nothing stacks up
+	BOOST_TEST( pc->jump() == false );
+	BOOST_TEST( em->getConst<RigidbodyComponent>( ent )->velocity.y == launchSpeed );
+	BOOST_TEST( em->getConst<TransformComponent>( ent )->impulseForces.y == 0.f );
+
+	// landed, the contact took the vertical velocity out
+	em->get<RigidbodyComponent>( ent )->velocity.y = 0.f;
+	BOOST_TEST( pc->jump() == true );
+	BOOST_TEST( em->getConst<RigidbodyComponent>( ent )->velocity.y == launchSpeed );
+
+	pc->setEntity( -1 );
+	em->removeEntity( ent );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
@@ -0,0 +1,38 @@
+#include <boost/test/unit_test.hpp>
+
+#include "renderer.hpp"
+#include "components.hpp"
+#include "entityManager.hpp"
+
+BOOST_AUTO_TEST_SUITE( RendererTests )
+
+// the matrix pass runs without a device, it only reads the EntityManager
+BOOST_AUTO_TEST_CASE( mesh_added_after_transform )
+{
+	EntityManager* em = EntityManager::instance();
+	em->registerComponent<TransformComponent>();
+	em->registerComponent<MeshComponent>();
+
+	Renderer* renderer = Renderer::instance();
+	renderer->updateModelMatrices();
+
+	// placed in one frame, the pass of the next frame does not see it yet
+	const E_ID ent = em->addEntity();
+	em->add<TransformComponent>( ent )->position = glm::vec3( 1.f, 2.f, 3.f );
+	em->advanceChangeTick();
+	renderer->updateModelMatrices();
+
+	// a frame later it gets a mesh and the untouched transform enters the view
+	em->advanceChangeTick();
+	em->add<MeshComponent>( ent );
+	renderer->updateModelMatrices();
+
+	const glm::mat4x4& model = em->getConst<TransformComponent>( ent )->modelMatrix;
+	BOOST_TEST( model[3].x == 1.f );
+	BOOST_TEST( model[3].y == 2.f );
+	BOOST_TEST( model[3].z == 3.f );
+
+	em->removeEntity( ent );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
@@ -0,0 +1,170 @@
+#include <boost/test/unit_test.hpp>
+#include <atomic>
+#include <thread>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+#include "taskCoroutine.hpp"
+
+namespace utf = boost::unit_test_framework;
+
+BOOST_AUTO_TEST_SUITE( TaskCoroutineTests )
+
+Task<int> Add( const int a, const int b )
+{
+	co_return a + b;
+}
+
+Task<int> AddOnWorkers( const int a, const int b )
+{
+	co_await resumeOnWorkers();
+	co_return co_await Add( a, b ) + co_await Add( 0, 0 );
+}
+
+BOOST_AUTO_TEST_CASE( nested_tasks, *utf::timeout( 60 ) )
+{
+	TaskScheduler* ts = TaskScheduler::instance();
+	ts->initialize( 4 );
+
+	bool valid = true;
+	for ( int i = 0; i < 1'000; i++ )
+	{
+		valid = valid && syncWait( AddOnWorkers( i, 1 ) ) == i + 1;
+	}
+
+	BOOST_TEST( valid == true );
+
+	ts->shutdown();
+}
+
+Task<void> HopThreads( const std::thread::id mainThread, std::atomic<int>& stage,
+	std::atomic<bool>& onWorker, std::atomic<bool>& backOnMain )
+{
+	stage = 1;
+
+	co_await resumeOnWorkers( enu_TASK_PRIORITY::background );
+	onWorker = std::this_thread::get_id() != mainThread;
+
+	co_await nextFrame();
+	backOnMain = std::this_thread::get_id() == mainThread;
+	stage = 2;
+}
+
+// nextFrame() only continues when the main thread drains its queue
+BOOST_AUTO_TEST_CASE( next_frame, *utf::timeout( 60 ) )
+{
+	TaskScheduler* ts = TaskScheduler::instance();
+	ts->initialize( 2 );
+
+	std::atomic<int> stage{ 0 };
+	std::atomic<bool> onWorker{ false };
+	std::atomic<bool> backOnMain{ false };
+
+	TaskFuture<void> done = spawn( HopThreads( std::this_thread::get_id(), stage, onWorker, backOnMain ) );
+
+	// give the worker time to reach nextFrame()
+	std::this_thread::sleep_for( std::chrono::milliseconds( 50 ) );
+	BOOST_TEST( stage.load() == 1 );
+	BOOST_TEST( done.isReady() == false );
+
+	while ( !done.isReady() )
+	{
+		ts->runMainThreadTasks();
+	}
+
+	BOOST_TEST( stage.load() == 2 );
+	BOOST_TEST( onWorker.load() == true );
+	BOOST_TEST( backOnMain.load() == true );
+
+	ts->shutdown();
+}
+
+Task<size_t> ReadSize( const std::string path )
+{
+	std::vector<char> bytes = co_await readFile( path );
+	co_return bytes.size();
+}
+
+Task<int> AwaitFuture()
+{
+	const int value = co_await submit( []() { return 20; } );
+	co_return value + 1;
+}
+
+BOOST_AUTO_TEST_CASE( file_reads_and_futures, *utf::timeout( 60 ) )
+{
+	TaskScheduler* ts = TaskScheduler::instance();
+	ts->initialize( 4 );
+
+	const std::string path = "task_coroutine_test.bin";
+	{
+		std::ofstream file( path, std::ios::binary );
+		file << std::string( 1'000, 'x' );
+	}
+
+	BOOST_TEST( syncWait( ReadSize( path ) ) == 1'000 );
+	BOOST_TEST( syncWait( ReadSize( "missing_file.bin" ) ) == 0 );
+	BOOST_TEST( syncWait( AwaitFuture() ) == 21 );
+
+	std::remove( path.c_str() );
+
+	ts->shutdown();
+}
+
+Task<int> AwaitFailedFuture()
+{
+	co_await resumeOnWorkers();
+	const int value = co_await submit( []() -> int { throw std::runtime_error( "decode failed" ); } );
+	co_return value + 1;
+}
+
+Task<void> FailOnNextFrame()
+{
+	co_await nextFrame();
+	throw std::runtime_error( "upload failed" );
+}
+
+Task<int> RecoverFrom( Task<int> task )
+{
+	try
+	{
+		co_return co_await task;
+	}
+	catch ( const std::runtime_error& )
+	{
+		co_return -1;
+	}
+}
+
+// exceptions travel to whoever awaits the task instead of ending the process
+BOOST_AUTO_TEST_CASE( exceptions, *utf::timeout( 60 ) )
+{
+	TaskScheduler* ts = TaskScheduler::instance();
+	ts->initialize( 2 );
+
+	BOOST_CHECK_THROW( syncWait( AwaitFailedFuture() ), std::runtime_error );
+	BOOST_CHECK_THROW( syncWait( FailOnNextFrame() ), std::runtime_error );
+	BOOST_TEST( syncWait( RecoverFrom( AwaitFailedFuture() ) ) == -1 );
+	BOOST_TEST( syncWait( RecoverFrom( AddOnWorkers( 1, 2 ) ) ) == 3 );
+
+	TaskFuture<void> spawned = spawn( FailOnNextFrame() );
+	while ( !spawned.isReady() )
+	{
+		ts->runMainThreadTasks();
+	}
+	BOOST_CHECK_THROW( spawned.wait(), std::runtime_error );
+
+	ts->shutdown();
+}
+
+// without workers every awaitable continues on the caller
+BOOST_AUTO_TEST_CASE( no_workers )
+{
+	BOOST_TEST( syncWait( AddOnWorkers( 2, 3 ) ) == 5 );
+	BOOST_TEST( syncWait( AwaitFuture() ) == 21 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
@@ -0,0 +1,126 @@
+#include <boost/test/unit_test.hpp>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+#include "taskFuture.hpp"
+
+namespace utf = boost::unit_test_framework;
+
+BOOST_AUTO_TEST_SUITE( TaskFutureTests )
+
+BOOST_AUTO_TEST_CASE( submit_and_get )
+{
+	TaskScheduler* ts = TaskScheduler::instance();
+	ts->initialize( 4 );
+
+	TaskFuture<int> answer = submit( []() { return 6 * 7; } );
+
+	BOOST_TEST( answer.valid() == true );
+	BOOST_TEST( answer.get() == 42 );
+	BOOST_TEST( answer.isReady() == true );
+
+	std::atomic<bool> ran{ false };
+	TaskFuture<void> done = submit( [&]() { ran = true; }, enu_TASK_PRIORITY::background );
+	done.wait();
+
+	BOOST_TEST( ran.load() == true );
+	BOOST_TEST( TaskFuture<int>().valid() == false );
+
+	ts->shutdown();
+}
+
+// read -> decode -> upload, every stage only sees the previous one's result
+BOOST_AUTO_TEST_CASE( continuations, *utf::timeout( 60 ) )
+{
+	TaskScheduler* ts = TaskScheduler::instance();
+	ts->initialize( 4 );
+
+	for ( int run = 0; run < 1'000; run++ )
+	{
+		TaskFuture<size_t> uploaded = submit( [run]() { return std::to_string( run ); } )
+			.then( []( const std::string& file ) { return std::vector<char>( file.begin(), file.end() ); } )
+			.then( []( const std::vector<char>& image ) { return image.size(); } );
+
+		BOOST_REQUIRE( uploaded.get() == std::to_string( run ).size() );
+	}
+
+	// chained onto a future that is already done
+	TaskFuture<int> first = submit( []() { return 1; } );
+	first.wait();
+
+	std::atomic<int> seen{ 0 };
+	first.then( [&]( int v ) { seen = v + 1; } ).wait();
+
+	BOOST_TEST( seen.load() == 2 );
+
+	ts->shutdown();
+}
+
+BOOST_AUTO_TEST_CASE( when_all, *utf::timeout( 60 ) )
+{
+	TaskScheduler* ts = TaskScheduler::instance();
+	ts->initialize( 4 );
+
+	std::vector<TaskFuture<size_t>> parts;
+	for ( size_t i = 0; i < 100; i++ )
+	{
+		parts.push_back( submit( [i]() { return i; } ) );
+	}
+
+	size_t sum = 0;
+	whenAll( parts ).then( [&]()
+	{
+		for ( const TaskFuture<size_t>& it : parts )
+		{
+			sum += it.get();
+		}
+	} ).wait();
+
+	BOOST_TEST( sum == 4'950 );
+
+	TaskFuture<int> a = submit( []() { return 1; } );
+	TaskFuture<std::string> b = submit( []() { return std::string( "two" ); } );
+	whenAll( a, b ).wait();
+
+	BOOST_TEST( a.isReady() == true );
+	BOOST_TEST( b.isReady() == true );
+	BOOST_TEST( whenAll( std::vector<TaskFuture<int>>() ).isReady() == true );
+
+	ts->shutdown();
+}
+
+// a throwing function leaves the worker running, the future and its continuations rethrow
+BOOST_AUTO_TEST_CASE( exceptions, *utf::timeout( 60 ) )
+{
+	TaskScheduler* ts = TaskScheduler::instance();
+	ts->initialize( 2 );
+
+	TaskFuture<int> failed = submit( []() -> int { throw std::runtime_error( "decode failed" ); } );
+
+	std::atomic<bool> continued{ false };
+	TaskFuture<int> chained = failed.then( [&]( int v ) { continued = true; return v; } );
+	TaskFuture<void> all = whenAll( failed, chained );
+
+	BOOST_CHECK_THROW( failed.get(), std::runtime_error );
+	BOOST_CHECK_THROW( chained.wait(), std::runtime_error );
+	all.wait();
+
+	BOOST_TEST( failed.isReady() == true );
+	BOOST_TEST( continued.load() == false );
+	BOOST_TEST( submit( []() { return 1; } ).get() == 1 );
+
+	ts->shutdown();
+}
+
+// without workers everything runs on the caller right away
+BOOST_AUTO_TEST_CASE( no_workers )
+{
+	TaskFuture<int> f = submit( []() { return 3; } ).then( []( int v ) { return v * 2; } );
+
+	BOOST_TEST( f.isReady() == true );
+	BOOST_TEST( f.get() == 6 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
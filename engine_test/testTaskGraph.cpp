@@ -0,0 +1,103 @@
+#include <boost/test/unit_test.hpp>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+
+#include "taskGraph.hpp"
+#include "components.hpp"
+
+BOOST_AUTO_TEST_SUITE( TaskGraphTests )
+
+// records the order the nodes finished in
+struct ExecutionLog
+{
+	std::mutex			mutex;
+	std::vector<size_t>	order;
+
+	std::function<void()> record( const size_t node )
+	{
+		return [this, node]()
+		{
+			std::lock_guard<std::mutex> lock( mutex );
+			order.push_back( node );
+		};
+	}
+
+	size_t position( const size_t node ) const
+	{
+		return std::find( order.begin(), order.end(), node ) - order.begin();
+	}
+};
+
+// a -> ( b, c ) -> d, run a few times to reuse the node tasks
+BOOST_AUTO_TEST_CASE( diamond_dependencies )
+{
+	TaskScheduler* ts = TaskScheduler::instance();
+	ts->initialize( 4 );
+
+	for ( int run = 0; run < 100; run++ )
+	{
+		ExecutionLog log;
+		TaskGraph graph;
+
+		TaskGraph::NodeId a = graph.add( "a", log.record( 0 ) );
+		TaskGraph::NodeId b = graph.add( "b", log.record( 1 ), { a } );
+		TaskGraph::NodeId c = graph.add( "c", log.record( 2 ), { a } );
+		graph.add( "d", log.record( 3 ), { b, c } );
+
+		graph.run();
+		graph.run();
+
+		BOOST_REQUIRE( log.order.size() == 8 );
+		log.order.resize( 4 );
+
+		BOOST_TEST( log.position( 0 ) < log.position( 1 ) );
+		BOOST_TEST( log.position( 0 ) < log.position( 2 ) );
+		BOOST_TEST( log.position( 1 ) < log.position( 3 ) );
+		BOOST_TEST( log.position( 2 ) < log.position( 3 ) );
+	}
+
+	ts->shutdown();
+}
+
+// writers are ordered by insertion, readers of different components are not
+BOOST_AUTO_TEST_CASE( component_conflicts )
+{
+	TaskGraph graph;
+	ExecutionLog log;
+
+	TaskGraph::NodeId move = graph.add( "move", log.record( 0 ) );
+	graph.writes<TransformComponent>( move );
+
+	TaskGraph::NodeId render = graph.add( "render", log.record( 1 ) );
+	graph.reads<TransformComponent, MeshComponent>( render );
+
+	TaskGraph::NodeId gravity = graph.add( "gravity", log.record( 2 ) );
+	graph.reads<RigidbodyComponent>( gravity );
+
+	graph.run();
+
+	BOOST_TEST( graph.getNode( move ).dependents.size() == 1 );
+	BOOST_TEST( graph.getNode( render ).dependencyCount == 1 );
+	BOOST_TEST( graph.getNode( gravity ).dependencyCount == 0 );
+	BOOST_TEST( log.position( 0 ) < log.position( 1 ) );
+}
+
+// without worker threads the nodes still run in dependency order
+BOOST_AUTO_TEST_CASE( serial_fallback )
+{
+	BOOST_REQUIRE( TaskScheduler::instance()->getThreadCount() == 0 );
+
+	TaskGraph graph;
+	ExecutionLog log;
+
+	TaskGraph::NodeId last = graph.add( "last", log.record( 0 ) );
+	TaskGraph::NodeId first = graph.add( "first", log.record( 1 ) );
+	graph.addDependency( last, first );
+
+	graph.run();
+
+	BOOST_TEST( ( log.order == std::vector<size_t>{ 1, 0 } ) );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
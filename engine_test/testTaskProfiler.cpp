@@ -0,0 +1,170 @@
+#include <boost/test/unit_test.hpp>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+
+#include "taskScheduler.hpp"
+#include "taskProfiler.hpp"
+
+namespace utf = boost::unit_test_framework;
+
+BOOST_AUTO_TEST_SUITE( TaskProfilerTests )
+
+class Sleeper : public RangedTask
+{
+public:
+	std::atomic<size_t> visited{ 0 };
+
+	Sleeper()
+	{
+		name = "sleeper";
+	}
+
+	void execute( const TaskRange& range ) override
+	{
+		volatile size_t sink = 0;
+		for ( size_t i = 0; i < 10'000; i++ )
+		{
+			sink = sink + i;
+		}
+
+		visited += range.end - range.start;
+	}
+};
+
+// every partition shows up once in the counters and the timeline
+BOOST_AUTO_TEST_CASE( counters_and_timeline, *utf::timeout( 60 ) )
+{
+	TaskScheduler* ts = TaskScheduler::instance();
+	ts->initialize( 4 );
+
+	TaskProfiler& profiler = ts->getProfiler();
+	profiler.setEnabled( true );
+
+	Sleeper task;
+	task.rangeSize = 256;
+	task.grainSize = 4;
+
+	ts->execute( &task );
+	ts->waitFor( &task );
+
+	profiler.setEnabled( false );
+
+	const std::vector<TaskWorkerStats> stats = profiler.getStats();
+	BOOST_REQUIRE( stats.size() == 5 );
+
+	size_t executed = 0;
+	size_t highWater = 0;
+	for ( const TaskWorkerStats& s : stats )
+	{
+		executed += s.tasksExecuted;
+		highWater = std::max( highWater, s.queueHighWater );
+		BOOST_TEST( s.steals <= s.stealAttempts );
+	}
+
+	BOOST_TEST( executed == 64 );
+	BOOST_TEST( highWater > 0 );
+
+	const std::vector<TaskTimelineEvent> timeline = profiler.getTimeline();
+	BOOST_REQUIRE( timeline.size() == 64 );
+
+	size_t covered = 0;
+	bool ordered = true;
+	for ( size_t i = 0; i < timeline.size(); i++ )
+	{
+		covered += timeline[i].rangeEnd - timeline[i].rangeStart;
+		ordered = ordered && timeline[i].begin <= timeline[i].end &&
+			( i == 0 || timeline[i - 1].begin <= timeline[i].begin );
+	}
+
+	BOOST_TEST( covered == 256 );
+	BOOST_TEST( ordered == true );
+	BOOST_TEST( std::string( timeline[0].name ) == "sleeper" );
+
+	// disabled, nothing is recorded
+	Sleeper quiet;
+	quiet.rangeSize = 64;
+	ts->execute( &quiet );
+	ts->waitFor( &quiet );
+
+	BOOST_TEST( profiler.getTimeline().size() == 64 );
+
+	profiler.clear();
+	BOOST_TEST( profiler.getTimeline().empty() == true );
+	BOOST_TEST( profiler.getStats()[0].tasksExecuted == 0 );
+
+	ts->shutdown();
+}
+
+// the ring buffer keeps the latest events only
+BOOST_AUTO_TEST_CASE( timeline_wraps )
+{
+	TaskProfiler profiler;
+	profiler.reset( 1 );
+
+	const size_t count = TaskProfiler::TimelineEventsPerThread + 10;
+	for ( size_t i = 0; i < count; i++ )
+	{
+		profiler.taskRun( 0, "task", i, i + 1, i * 10, i * 10 + 5 );
+	}
+
+	const std::vector<TaskTimelineEvent> timeline = profiler.getTimeline();
+
+	BOOST_REQUIRE( timeline.size() == TaskProfiler::TimelineEventsPerThread );
+	BOOST_TEST( timeline.front().rangeStart == 10 );
+	BOOST_TEST( timeline.back().rangeStart == count - 1 );
+	BOOST_TEST( profiler.getStats()[0].tasksExecuted == count );
+}
+
+// the depth counts from the moment the profiler is turned on
+BOOST_AUTO_TEST_CASE( queue_depth_while_enabled )
+{
+	TaskProfiler profiler;
+	profiler.reset( 1 );
+
+	for ( size_t i = 0; i < 5; i++ )
+	{
+		profiler.queuePushed( 0 );
+	}
+
+	profiler.setEnabled( true );
+	profiler.queuePushed( 0 );
+	BOOST_TEST( profiler.getStats()[0].queueHighWater == 1 );
+
+	// the partitions queued before come out without taking the depth below 0
+	for ( size_t i = 0; i < 4; i++ )
+	{
+		profiler.queuePopped( 0 );
+	}
+
+	profiler.queuePushed( 0 );
+	profiler.queuePushed( 0 );
+	BOOST_TEST( profiler.getStats()[0].queueHighWater == 2 );
+
+	profiler.setEnabled( false );
+	profiler.queuePushed( 0 );
+	profiler.queuePushed( 0 );
+	profiler.queuePushed( 0 );
+	BOOST_TEST( profiler.getStats()[0].queueHighWater == 2 );
+}
+
+BOOST_AUTO_TEST_CASE( chrome_trace )
+{
+	TaskProfiler profiler;
+	profiler.reset( 2 );
+
+	profiler.taskRun( 0, "physics", 0, 16, 1'000, 3'000 );
+	profiler.taskRun( 2, "odd \"name\"", 0, 1, 2'000, 2'500 );
+
+	const std::string json = profiler.toChromeTrace();
+
+	BOOST_TEST( json.find( "\"traceEvents\"" ) != std::string::npos );
+	BOOST_TEST( json.find( "\"name\":\"physics\"" ) != std::string::npos );
+	BOOST_TEST( json.find( "\"ts\":1.000,\"dur\":2.000" ) != std::string::npos );
+	BOOST_TEST( json.find( "odd _name_" ) != std::string::npos );
+	BOOST_TEST( json.find( "\"name\":\"other 2\"" ) != std::string::npos );
+	BOOST_TEST( json.back() == '}' );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
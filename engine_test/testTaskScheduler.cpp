@@ -1,5 +1,15 @@
 #include <boost/test/unit_test.hpp>
+#include <set>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <future>
 #include "taskScheduler.hpp"
+#include "parallel.hpp"
+#include "components.hpp"
+#include "entityManager.hpp"
+
+namespace utf = boost::unit_test_framework;
 
 BOOST_AUTO_TEST_SUITE( TaskSchedulerTests )
 
@@ -60,4 +70,365 @@ BOOST_AUTO_TEST_CASE( a_million_doubles )
 	ts->shutdown();
 }
 
+// ten thousand partitions for four workers, nothing may get lost
+BOOST_AUTO_TEST_CASE( fine_grained_partitions )
+{
+	TaskScheduler* ts = TaskScheduler::instance();
+	ts->initialize( 4 );
+
+	std::unique_ptr<NumberDoubler> nd = std::make_unique<NumberDoubler>();
+	nd->init();
+	nd->grainSize = 100;
+
+	ts->execute( nd.get() );
+	ts->waitFor( nd.get() );
+
+	bool valid = true;
+	for ( size_t i = 0; i < nd->numbers.size(); i++ )
+	{
+		valid = valid && nd->output[i] == 2 * nd->numbers[i];
+	}
+
+	BOOST_TEST( valid == true );
+
+	ts->shutdown();
+}
+
+// tiny tasks back to back, a lost wakeup would hang the loop
+class Counter : public RangedTask
+{
+public:
+	std::atomic<size_t> visited{ 0 };
+
+	void execute( const TaskRange& range )
+	{
+		visited += range.end - range.start;
+	}
+};
+
+BOOST_AUTO_TEST_CASE( back_to_back_small_tasks, *utf::timeout( 60 ) )
+{
+	TaskScheduler* ts = TaskScheduler::instance();
+	ts->initialize( 4 );
+
+	const size_t taskCount = 5'000;
+	const size_t taskSize = 64;
+
+	bool valid = true;
+	for ( size_t i = 0; i < taskCount; i++ )
+	{
+		Counter counter;
+		counter.rangeSize = taskSize;
+		counter.grainSize = 4 + i % 16;
+
+		ts->execute( &counter );
+		ts->waitFor( &counter );
+
+		valid = valid && counter.visited == taskSize;
+	}
+
+	// several tasks in flight at once, waited for in reverse order
+	std::vector<std::unique_ptr<Counter>> counters;
+	for ( size_t i = 0; i < 64; i++ )
+	{
+		counters.push_back( std::make_unique<Counter>() );
+		counters.back()->rangeSize = taskSize;
+		counters.back()->grainSize = 1;
+		ts->execute( counters.back().get() );
+	}
+
+	for ( auto it = counters.rbegin(); it != counters.rend(); ++it )
+	{
+		ts->waitFor( it->get() );
+		valid = valid && ( *it )->visited == taskSize;
+	}
+
+	BOOST_TEST( valid == true );
+
+	ts->shutdown();
+}
+
+// far more partitions in flight than workers, the queues have to grow
+BOOST_AUTO_TEST_CASE( ten_thousand_tasks_in_flight, *utf::timeout( 60 ) )
+{
+	TaskScheduler* ts = TaskScheduler::instance();
+	ts->initialize( 4 );
+
+	const size_t ranByCallerBefore = ts->getQueueStats().ranByCaller;
+
+	std::vector<std::unique_ptr<Counter>> counters( 10'000 );
+	for ( auto& it : counters )
+	{
+		it = std::make_unique<Counter>();
+		it->rangeSize = 16;
+		it->grainSize = 8;
+		ts->execute( it.get() );
+	}
+
+	bool valid = true;
+	for ( auto& it : counters )
+	{
+		ts->waitFor( it.get() );
+		valid = valid && it->visited == 16;
+	}
+
+	BOOST_TEST( valid == true );
+	BOOST_TEST( ts->getQueueStats().ranByCaller == ranByCallerBefore );
+	BOOST_TEST( ts->getQueueStats().queued == 0 );
+
+	ts->shutdown();
+}
+
+// with a limit the excess runs on the submitting thread instead of being queued
+BOOST_AUTO_TEST_CASE( queue_limit_backpressure )
+{
+	TaskScheduler* ts = TaskScheduler::instance();
+	ts->initialize( 2 );
+	ts->setQueueLimit( 16 );
+
+	const size_t ranByCallerBefore = ts->getQueueStats().ranByCaller;
+
+	std::unique_ptr<NumberDoubler> nd = std::make_unique<NumberDoubler>();
+	nd->init();
+	nd->grainSize = 1'000;
+
+	ts->execute( nd.get() );
+	ts->waitFor( nd.get() );
+
+	bool valid = true;
+	for ( size_t i = 0; i < nd->numbers.size(); i++ )
+	{
+		valid = valid && nd->output[i] == 2 * nd->numbers[i];
+	}
+
+	BOOST_TEST( valid == true );
+	BOOST_TEST( ts->getQueueStats().ranByCaller > ranByCallerBefore );
+	BOOST_TEST( ts->getQueueStats().queuedHighWater >= 16 );
+
+	ts->setQueueLimit( 0 );
+	ts->shutdown();
+}
+
+// the lambda helpers give the same results as plain loops
+BOOST_AUTO_TEST_CASE( parallel_for_and_reduce )
+{
+	TaskScheduler* ts = TaskScheduler::instance();
+	ts->initialize( 4 );
+
+	std::vector<int64_t> values( 100'003 );
+	ts->parallelFor( 0, values.size(), 0, [&]( size_t i ) { values[i] = (int64_t)( i * 7 % 1'000 ) - 500; } );
+
+	int64_t serialSum = 0;
+	int64_t serialMax = INT64_MIN;
+	bool valid = true;
+	for ( size_t i = 0; i < values.size(); i++ )
+	{
+		valid = valid && values[i] == (int64_t)( i * 7 % 1'000 ) - 500;
+		serialSum += values[i];
+		serialMax = std::max( serialMax, values[i] * values[i] );
+	}
+
+	const int64_t sum = ts->parallelReduce( 0, values.size(), int64_t( 0 ),
+		[&]( size_t i ) { return values[i]; },
+		[]( int64_t a, int64_t b ) { return a + b; } );
+
+	const int64_t max = ts->parallelReduce( 0, values.size(), INT64_MIN,
+		[&]( size_t i ) { return values[i] * values[i]; },
+		[]( int64_t a, int64_t b ) { return std::max( a, b ); } );
+
+	// subranges, explicit grains and empty ranges
+	std::vector<int> touched( 1'000, 0 );
+	ts->parallelFor( 100, 900, 7, [&]( size_t i ) { touched[i]++; } );
+	ts->parallelFor( 5, 5, 1, [&]( size_t i ) { touched[i]++; } );
+
+	bool subrange = true;
+	for ( size_t i = 0; i < touched.size(); i++ )
+	{
+		subrange = subrange && touched[i] == ( i >= 100 && i < 900 ? 1 : 0 );
+	}
+
+	BOOST_TEST( valid == true );
+	BOOST_TEST( sum == serialSum );
+	BOOST_TEST( max == serialMax );
+	BOOST_TEST( subrange == true );
+	BOOST_TEST( ts->parallelReduce( 3, 3, 42, []( size_t ) { return 0; }, []( int a, int b ) { return a + b; } ) == 42 );
+
+	ts->shutdown();
+}
+
+// every entity of the view is visited exactly once, split over the workers
+BOOST_AUTO_TEST_CASE( parallel_view_iteration )
+{
+	TaskScheduler* ts = TaskScheduler::instance();
+	ts->initialize( 4 );
+
+	EntityManager* em = EntityManager::instance();
+	em->registerComponent<TransformComponent>();
+	em->registerComponent<RigidbodyComponent>();
+
+	std::vector<E_ID> ids = em->addEntities( 10'000 );
+	for ( E_ID id : ids )
+	{
+		em->add<TransformComponent>( id );
+		em->add<RigidbodyComponent>( id );
+	}
+
+	parallelForEach( em->view<TransformComponent, RigidbodyComponent>(), []( E_ID id, 
+		TransformComponent& tc, RigidbodyComponent& )
+	{
+		tc.position.x += (float)id.v + 1.f;
+	} );
+
+	bool valid = true;
+	for ( E_ID id : ids )
+	{
+		valid = valid && em->get<TransformComponent>( id )->position.x == (float)id.v + 1.f;
+	}
+
+	BOOST_TEST( valid == true );
+
+	em->removeEntities( ids );
+	ts->shutdown();
+}
+
+
+// stands in for an asset load, every partition blocks until the test releases it
+class GatedTask : public RangedTask
+{
+public:
+	std::thread::id			caller;
+	std::shared_future<void>	release;
+	std::atomic<size_t>		started{ 0 };
+	std::atomic<size_t>		done{ 0 };
+	std::atomic<bool>		ranOnCaller{ false };
+
+	void execute( const TaskRange& range ) override
+	{
+		if ( std::this_thread::get_id() == caller )
+		{
+			ranOnCaller = true;
+		}
+
+		started++;
+		release.wait();
+		done += range.end - range.start;
+	}
+};
+
+// frames keep going while a long background task is still running
+BOOST_AUTO_TEST_CASE( background_priority, *utf::timeout( 60 ) )
+{
+	TaskScheduler* ts = TaskScheduler::instance();
+	ts->initialize( 2 );
+
+	std::promise<void> release;
+
+	GatedTask load;
+	load.caller = std::this_thread::get_id();
+	load.release = release.get_future().share();
+	load.rangeSize = 8;
+	load.grainSize = 1;
+	load.priority = enu_TASK_PRIORITY::background;
+	ts->execute( &load );
+
+	// a worker is stuck in the load before any frame runs
+	while ( load.started.load() == 0 )
+	{
+		std::this_thread::yield();
+	}
+
+	bool valid = true;
+	for ( size_t i = 0; i < 10; i++ )
+	{
+		Counter frame;
+		frame.rangeSize = 64;
+		frame.grainSize = 8;
+
+		ts->execute( &frame );
+		ts->waitFor( &frame );
+
+		valid = valid && frame.visited == 64;
+	}
+
+	// every frame finished while the load was held back
+	BOOST_TEST( valid == true );
+	BOOST_TEST( load.done.load() == 0 );
+
+	release.set_value();
+	ts->waitFor( &load );
+
+	BOOST_TEST( load.done.load() == 8 );
+	BOOST_TEST( load.ranOnCaller.load() == false );
+	BOOST_TEST( ts->getQueueStats().queuedBackground == 0 );
+
+	ts->shutdown();
+}
+
+// functions queued from the workers only run when the main thread drains them
+BOOST_AUTO_TEST_CASE( main_thread_queue )
+{
+	TaskScheduler* ts = TaskScheduler::instance();
+	ts->initialize( 4 );
+
+	const std::thread::id mainThread = std::this_thread::get_id();
+	size_t ranOnMain = 0;
+
+	ts->parallelFor( 0, 100, 1, [&]( size_t )
+	{
+		ts->runOnMainThread( [&]()
+		{
+			if ( std::this_thread::get_id() == mainThread )
+			{
+				ranOnMain++;
+			}
+		} );
+	} );
+
+	BOOST_TEST( ranOnMain == 0 );
+	BOOST_TEST( ts->runMainThreadTasks() == 100 );
+	BOOST_TEST( ranOnMain == 100 );
+	BOOST_TEST( ts->runMainThreadTasks() == 0 );
+
+	ts->shutdown();
+}
+
+BOOST_AUTO_TEST_CASE( configured_workers, *utf::timeout( 60 ) )
+{
+	TaskScheduler* ts = TaskScheduler::instance();
+
+	TaskSchedulerConfig config;
+	config.threads = 3;
+	config.pinWorkers = true;
+	ts->initialize( config );
+
+	// counted from the affinity set, a taskset or container cpuset can be far below hardware_concurrency()
+	const size_t cpus = TaskScheduler::getAvailableCpuCount();
+
+	BOOST_TEST( ts->getThreadCount() == 3 );
+#if defined( _WIN32 ) || defined( __linux__ )
+	BOOST_TEST( ts->getPinnedThreadCount() == 3 );
+	BOOST_TEST( ts->isMainThreadPinned() == ( cpus > 1 ) );
+#endif
+
+	NumberDoubler task;
+	task.init();
+	ts->execute( &task );
+	ts->waitFor( &task );
+	BOOST_TEST( task.output[500] == 1000 );
+
+	ts->shutdown();
+	BOOST_TEST( ts->getPinnedThreadCount() == 0 );
+	BOOST_TEST( ts->isMainThreadPinned() == false );
+
+	// the automatic count leaves a cpu to the main thread, but never goes below one worker
+	config = TaskSchedulerConfig();
+	ts->initialize( config );
+
+	BOOST_TEST( ts->getThreadCount() == std::max<size_t>( cpus, 2 ) - 1 );
+	BOOST_TEST( ts->getPinnedThreadCount() == 0 );
+	BOOST_TEST( ts->isMainThreadPinned() == false );
+
+	ts->shutdown();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file